@@ -0,0 +1,21 @@
+// File name: projects/12/MathTest/MathBench/MathBench.tst
+
+// Cycle benchmark for the OS Math class, run on the CPU emulator.
+// Translate this directory together with the OS .vm files (including the
+// Math.vm under test) into MathBench.asm first. Each output line records the
+// clock at the start of a phase. See Main.jack for how to read the numbers.
+
+load MathBench.asm,
+output-file MathBench.out,
+output-list time%D1.10.1 RAM[24574]%D1.6.1 RAM[24575]%D1.6.1;
+
+while RAM[24574] < 1 { ticktock; }
+output;
+while RAM[24574] < 2 { ticktock; }
+output;
+while RAM[24574] < 3 { ticktock; }
+output;
+while RAM[24574] < 4 { ticktock; }
+output;
+while RAM[24574] < 5 { ticktock; }
+output;
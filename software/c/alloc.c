@@ -0,0 +1,249 @@
+/* Tracked allocator with arena scopes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+
+/*
+Every block starts with a header linking it into its arena's list, so an
+arena can free what is left in it and mem_free() knows the size it is
+giving back. The union keeps what follows the header aligned for any type.
+*/
+typedef union Header {
+    struct {
+        union Header *prev;
+        union Header *next;
+        Arena *arena;
+        size_t size;
+    } block;
+
+    long double align_ld;
+    long long align_ll;
+    void *align_p;
+} Header;
+
+
+struct Arena {
+    Header blocks;     // sentinel of a circular list
+    Arena *parent;
+};
+
+
+static Arena ROOT = {{{&ROOT.blocks, &ROOT.blocks, &ROOT, 0}}, NULL};
+static Arena *CURRENT = &ROOT;
+
+static size_t LIVE = 0;
+static MemStats TOTAL = {0, 0, 0, 0, 0, 0};
+static MemStats PHASE = {0, 0, 0, 0, 0, 0};
+static MemHook HOOK = NULL;
+static MemFail ON_FAIL = NULL;
+
+
+static void link_block(Arena *arena, Header *h)
+{
+    Header *head = &arena->blocks;
+
+    h->block.arena = arena;
+    h->block.prev = head;
+    h->block.next = head->block.next;
+    head->block.next->block.prev = h;
+    head->block.next = h;
+}
+
+
+static void unlink_block(Header *h)
+{
+    h->block.prev->block.next = h->block.next;
+    h->block.next->block.prev = h->block.prev;
+}
+
+
+static void count(size_t allocs, size_t reallocs, size_t frees, size_t bytes)
+{
+    TOTAL.allocs += allocs;
+    TOTAL.reallocs += reallocs;
+    TOTAL.frees += frees;
+    TOTAL.bytes += bytes;
+
+    PHASE.allocs += allocs;
+    PHASE.reallocs += reallocs;
+    PHASE.frees += frees;
+    PHASE.bytes += bytes;
+
+    if (LIVE > TOTAL.peak)
+        TOTAL.peak = LIVE;
+
+    if (LIVE > PHASE.peak)
+        PHASE.peak = LIVE;
+}
+
+
+void * mem_alloc(size_t size)
+{
+    Header *h = malloc(sizeof(*h) + size);
+    if (!h)
+        return NULL;
+
+    h->block.size = size;
+    link_block(CURRENT, h);
+
+    LIVE += size;
+    count(1, 0, 0, size);
+
+    return h + 1;
+}
+
+
+void * mem_calloc(size_t count, size_t size)
+{
+    if (size && count > (size_t)-1 / size)
+        return NULL;
+
+    void *result = mem_alloc(count * size);
+    if (result)
+        memset(result, 0, count * size);
+
+    return result;
+}
+
+
+void * mem_realloc(void *ptr, size_t size)
+{
+    if (!ptr)
+        return mem_alloc(size);
+
+    Header *h = (Header *)ptr - 1;
+    Arena *arena = h->block.arena;
+    size_t old_size = h->block.size;
+
+    // the block may move, so take it out of the list while it does
+    unlink_block(h);
+
+    Header *moved = realloc(h, sizeof(*h) + size);
+    if (!moved) {
+        // the old block is still good and still the caller's
+        link_block(arena, h);
+        return NULL;
+    }
+
+    moved->block.size = size;
+    link_block(arena, moved);
+
+    LIVE = LIVE - old_size + size;
+    count(0, 1, 0, size);
+
+    return moved + 1;
+}
+
+
+static void release(Header *h)
+{
+    LIVE -= h->block.size;
+    count(0, 0, 1, 0);
+
+    free(h);
+}
+
+
+void mem_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    Header *h = (Header *)ptr - 1;
+    unlink_block(h);
+    release(h);
+}
+
+
+Arena * arena_begin(void)
+{
+    // the arena itself is not tracked, it is not part of any job's memory
+    Arena *arena = malloc(sizeof(*arena));
+    if (!arena)
+        return NULL;
+
+    arena->blocks.block.prev = &arena->blocks;
+    arena->blocks.block.next = &arena->blocks;
+    arena->blocks.block.arena = arena;
+    arena->blocks.block.size = 0;
+    arena->parent = CURRENT;
+
+    CURRENT = arena;
+
+    return arena;
+}
+
+
+void arena_end(Arena *arena)
+{
+    if (!arena || arena == &ROOT)
+        return;
+
+    Header *head = &arena->blocks;
+
+    while (head->block.next != head) {
+        Header *h = head->block.next;
+        unlink_block(h);
+        release(h);
+    }
+
+    CURRENT = arena->parent;
+    free(arena);
+}
+
+
+MemStats mem_stats(void)
+{
+    TOTAL.live = LIVE;
+    return TOTAL;
+}
+
+
+void mem_stats_reset(void)
+{
+    MemStats empty = {0, 0, 0, 0, 0, 0};
+
+    // what is live stays live, only the counting starts again
+    TOTAL = empty;
+    TOTAL.live = LIVE;
+    TOTAL.peak = LIVE;
+}
+
+
+void mem_hook(MemHook hook)
+{
+    HOOK = hook;
+}
+
+
+void mem_phase(const char *name)
+{
+    PHASE.live = LIVE;
+
+    if (HOOK)
+        HOOK(name, PHASE);
+
+    MemStats empty = {0, 0, 0, 0, 0, 0};
+    PHASE = empty;
+    PHASE.peak = LIVE;
+}
+
+
+void mem_on_fail(MemFail handler)
+{
+    ON_FAIL = handler;
+}
+
+
+void mem_fail(char *message)
+{
+    if (ON_FAIL)
+        ON_FAIL(message);
+
+    printf("%s\n", message);
+    exit(1);
+}
@@ -0,0 +1,79 @@
+/* The tracked allocator every container allocates through */
+
+#ifndef ALLOC
+#define ALLOC
+
+#include <stddef.h>
+
+
+/*
+Ownership
+
+Strings, Arrays, Vectors, HTs and SrcMaps get their memory from mem_alloc()
+and friends below rather than malloc(). Every block belongs to the arena
+that was current when it was allocated; arena_end() frees whatever is still
+allocated in it. An assembly job runs in an arena of its own, so anything
+it leaks is handed back when the job is done and a long running process
+stays flat however many programs it assembles:
+
+    Arena *job = arena_begin();
+    ... create tables, read and assemble lines ...
+    arena_end(job);    // nothing the job allocated is left
+
+Blocks can still be freed one at a time with mem_free(), and should be,
+so the peak stays low during a job. Arenas nest and must be ended in the
+reverse order they were begun. Nothing allocated in an arena may be used
+after it ends. Not thread safe: chash, which is shared between threads,
+uses malloc().
+*/
+typedef struct Arena Arena;
+
+void * mem_alloc(size_t);
+void * mem_calloc(size_t count, size_t size);
+void * mem_realloc(void *, size_t);
+void mem_free(void *);
+
+// new arena, current until it ends; allocations outside of any arena are
+// never freed in bulk
+Arena * arena_begin(void);
+void arena_end(Arena *);
+
+
+typedef struct {
+    size_t allocs;    // mem_alloc and mem_calloc calls
+    size_t reallocs;
+    size_t frees;     // mem_free calls and blocks freed by arena_end
+    size_t bytes;     // bytes asked for by allocs and reallocs
+    size_t live;      // bytes allocated and not freed yet
+    size_t peak;      // most bytes live at any one time
+} MemStats;
+
+// totals since the start, or the last reset, for every container at once:
+// a test or benchmark resets them, runs some work and asserts on how much
+// allocating the work did
+MemStats mem_stats(void);
+void mem_stats_reset(void);
+
+/*
+Per phase accounting: mem_phase(name) ends the phase called name, passing
+the hook the stats for just that phase (live is the total at its end, peak
+the highest it got during it), and starts the next one.
+*/
+typedef void (*MemHook)(const char *phase, MemStats);
+
+void mem_hook(MemHook);    // NULL to stop reporting
+void mem_phase(const char *name);
+
+/*
+Running out of memory where the caller has no way to fail softly, say a
+String's buffer or a table that has to grow: mem_fail() passes message to
+the handler set with mem_on_fail(), which must not return, or prints it
+and exits if there is none. asm_run() sets one so that only the job fails,
+not a daemon serving it.
+*/
+typedef void (*MemFail)(char *message);
+
+void mem_on_fail(MemFail);    // NULL to exit again
+void mem_fail(char *message);
+
+#endif
@@ -1,9 +1,14 @@
 /* My attempt at a dynamic array. */
 
+#include <stdint.h>
+#include <string.h>
+
+#include "alloc.h"
 #include "array.h"
 
 
 #define ARRAY_INIT_SIZE 16
+#define ARRAY_GROWTH 2.0
 #define OOM "-------- OUT OF MEMORY ---------\n"
 
 
@@ -30,38 +35,30 @@ void debug(char * name, Item * arr, size_t len)
 }
 
 
-void copy(Item * src, Item * dest, size_t len)
-{
-    for (size_t i = 0; i < len; i++) {
-        // printf("copying over %d\n", *(int *)src[i].data);
-        dest[i] = src[i];
-    }
-}
-
-
 void freearray(Array *arr)
 {
-    if (!arr->items)
+    if (!arr)
         return;
 
-    free(arr);
-
-    if (arr->items != NULL)
-        arr->items = NULL;
+    // the items block first, it can't be reached once arr is gone
+    mem_free(arr->items);
+    mem_free(arr);
 }
 
 
-void _resize(Array *arr)
+/* realloc the items to new_size, zeroing any new slots */
+static void _resize(Array *arr, size_t new_size)
 {
-    Item *tmp = calloc(sizeof(*tmp), arr->_total_size);
+    Item *tmp = mem_realloc(arr->items, sizeof(*tmp) * new_size);
     if (!tmp)
         goto error;
 
-    // copy existing items to resized memory block
-    copy(arr->items, tmp, arr->length);
+    // realloc leaves the grown part uninitialised, empty slots are NULL
+    if (new_size > arr->_total_size)
+        memset(tmp + arr->_total_size, 0, sizeof(*tmp) * (new_size - arr->_total_size));
 
-    free(arr->items);
     arr->items = tmp;
+    arr->_total_size = new_size;
 
     return;
 
@@ -74,36 +71,56 @@ error:
 
 static void resize(Array *arr)
 {
-    // check if we actually need to resize
-    if ((arr->length / (double)arr->_total_size) < 0.75)
+    // grow only once there is no room left for the next item
+    if (arr->length < arr->_total_size)
         return;
 
-    if ((arr->_total_size * 2) < arr->_total_size) {
+    size_t new_size = (size_t)(arr->_total_size * arr->growth);
+
+    // small sizes and factors close to 1 could round to no growth
+    if (new_size <= arr->_total_size)
+        new_size = arr->_total_size + 1;
+
+    if (new_size > SIZE_MAX / sizeof(Item)) {
         // overflow
         myprint("resize", "_total_size", "overflow issue");
         return;
     }
 
-    // double array size: this is probs not very efficient!
-    arr->_total_size *= 2;
-    _resize(arr);
+    _resize(arr, new_size);
+}
+
 
+void array_growth(Array *arr, double factor)
+{
+    if (factor > 1)
+        arr->growth = factor;
 }
 
 
-Array * newarr(NewItemHandler callback)
+void array_shrink(Array *arr)
+{
+    size_t new_size = arr->length ? arr->length : 1;
+
+    if (new_size < arr->_total_size)
+        _resize(arr, new_size);
+}
+
+
+Array * newarr_sized(NewItemHandler callback, size_t count)
 {
-    Array *arr = malloc(sizeof(*arr));
+    Array *arr = mem_alloc(sizeof(*arr));
     if (!arr) {
         myprint("create", "arr", OOM);
         goto error;
     }
 
     arr->length = 0;
-    arr->_total_size = ARRAY_INIT_SIZE;
+    arr->_total_size = count ? count : 1;
+    arr->growth = ARRAY_GROWTH;
     arr->callback = callback;
 
-    Item *container = calloc(sizeof(*container), arr->_total_size);
+    Item *container = mem_calloc(arr->_total_size, sizeof(*container));
     if (!container)
         goto container_calloc_error;
 
@@ -113,7 +130,7 @@ Array * newarr(NewItemHandler callback)
 
 container_calloc_error:
     // free array to avoid dangling pointers
-    free(arr);
+    mem_free(arr);
     myprint("create", "container", OOM);
 
 error:
@@ -121,6 +138,12 @@ error:
 }
 
 
+Array * newarr(NewItemHandler callback)
+{
+    return newarr_sized(callback, ARRAY_INIT_SIZE);
+}
+
+
 void push(Array *arr, void *value)
 {
     if (value == NULL)
@@ -34,6 +34,7 @@ typedef struct {
     // array->items[array.length] == next free location (off-by-one).
     size_t length;
     size_t _total_size;       // total allocated memory for the array
+    double growth;            // _total_size is multiplied by this when full
     NewItemHandler callback;  // custom function for creating a new item
     Item *items;              // pointer to first item in the array
 } Array;
@@ -48,6 +49,8 @@ typedef struct {
 
 
 Array * newarr(NewItemHandler callback);
+/* array with room for count items, so count pushes never resize */
+Array * newarr_sized(NewItemHandler callback, size_t count);
 
 void push(Array *, void *);   // add new value to the end of of the array
 Item pop(Array *);            // Remove last value from the array
@@ -58,4 +61,9 @@ bool array_next(AIT *);
 
 void freearray(Array *);
 
+// factor the array grows by when full, must be above 1 (default 2)
+void array_growth(Array *, double factor);
+// give back unused room, the array keeps space for at least one item
+void array_shrink(Array *);
+
 #endif
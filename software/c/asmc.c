@@ -0,0 +1,93 @@
+/*
+Assembler client: a drop in for the batch assembler (same arguments, same
+out.hack, out.sym and out.map) that has a running asmd do the work. With no
+daemon to talk to it assembles in process instead.
+
+    ./asmc.out [file.asm]   default t.asm, daemon at $ASMD_SOCKET or
+                            /tmp/hack-asm.sock
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "assembler.h"
+#include "daemon.h"
+
+
+static void fail(const char *message)
+{
+    printf("%s\n", message);
+    exit(1);
+}
+
+
+static char * read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return NULL;
+
+    size_t total = 4096;
+    char *data = malloc(total);
+    *size = 0;
+
+    while (data) {
+        *size += fread(data + *size, 1, total - *size, fp);
+
+        if (*size < total)
+            break;
+
+        total *= 2;
+        char *tmp = realloc(data, total);
+        if (!tmp)
+            free(data);
+        data = tmp;
+    }
+
+    fclose(fp);
+    return data;
+}
+
+
+static void write_file(const char *path, const char *mode, const char *data, size_t size)
+{
+    FILE *fp = fopen(path, mode);
+
+    if (!fp || fwrite(data, 1, size, fp) != size || fclose(fp) != 0)
+        fail("Could not write the output files");
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *path = argc > 1 ? argv[1] : "t.asm";
+    AsmdReply reply;
+    size_t size;
+
+    char *input = read_file(path, &size);
+    if (!input)
+        fail("Could not open the input file");
+
+    // no daemon: the same job as the batch assembler, in this process
+    if (asmd_request(asmd_socket(), "assemble", input, size, &reply) != 0) {
+        char error[256];
+
+        free(input);
+        if (asm_file(path, error, sizeof(error)) != 0)
+            fail(error);
+
+        return 0;
+    }
+
+    free(input);
+
+    if (!reply.ok)
+        fail(reply.error);
+
+    write_file(HACK_FILE, "wb", reply.output[0], reply.size[0]);
+    write_file(SYM_FILE, "wb", reply.output[1], reply.size[1]);
+    write_file(SRCMAP_FILE, "wb", reply.output[2], reply.size[2]);
+
+    asmd_reply_free(&reply);
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+/*
+Assembler daemon: answers assemble requests from asmc on a Unix domain
+socket (see daemon.h) until it is killed.
+
+    ./asmd.out [socket]     default $ASMD_SOCKET or /tmp/hack-asm.sock
+*/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "daemon.h"
+
+
+int main(int argc, char *argv[])
+{
+    const char *path = argc > 1 ? argv[1] : asmd_socket();
+
+    int fd = asmd_listen(path);
+    if (fd < 0 && errno == EADDRINUSE) {
+        printf("asmd is already running on %s\n", path);
+        return 1;
+    }
+
+    if (fd < 0) {
+        printf("Could not listen on %s\n", path);
+        return 1;
+    }
+
+    printf("asmd listening on %s\n", path);
+    fflush(stdout);
+
+    asmd_serve(fd, 0);
+
+    return 0;
+}
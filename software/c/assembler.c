@@ -0,0 +1,688 @@
+/* Hack assembler: .asm text in, .hack, symbol map and source map out. */
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "assembler.h"
+#include "mystring.h"
+#include "hash.h"
+#include "render.h"
+#include "srcmap.h"
+#include "strview.h"
+#include "tables.h"
+#include "vector.h"
+
+// ----------- ---- UTILS -----------------
+
+int first(String str)
+{
+    int result = -1;
+
+    for (size_t i = 0; i < str.length; i++) {
+        char curr = charat(str, i);
+
+        // space character, we can ignore
+        if (curr == ' ')
+            continue;
+
+        // empty line
+        if (curr == '\n')
+            break;
+
+        // comment
+        if (
+            curr == '/' &&
+            (i + 1 < str.length && cstr(&str)[i + 1] == '/')
+        )
+            break;
+
+        // we've found the first proper char
+        result = (int)i;
+        break;
+    }
+
+    return result;
+}
+
+
+String clean(String str)
+{
+    String ns = newstr(""); 
+    size_t i = 0;
+
+    while (i < str.length && cstr(&str)[i] == ' ')
+        i++;
+
+    while (i < str.length) {
+        char curr = charat(str, i);
+
+        // reached the end of valid asm
+        // NOTE: this does not support space inbetween valid asm statements
+        if (curr == ' ' || curr == '\n')
+            break;
+
+        // comment
+        if (
+            curr == '/' &&
+            (i + 1 < str.length && cstr(&str)[i + 1] == '/')
+        )
+            break;
+
+        ns = concatChar(ns, &curr);
+        i++;
+    }
+
+    return ns;
+}
+
+
+String str_reverse(String str)
+{
+    String ns = newstr("");
+
+    // cast to int as size_t doesn't go below 0
+    int i = (int)str.length - 1;
+
+    while (i >= 0) {
+        char curr = charat(str, (size_t)i);
+        ns = concatChar(ns, &curr);
+
+        i--;
+    }
+
+    return ns;
+}
+
+
+String dec_to_str(unsigned int num)
+{
+    // the loop below never runs for 0, which would leave us with ""
+    if (num == 0)
+        return newstr("0");
+
+    String ns = newstr("");
+
+    char d[2];
+    d[1] = '\0';
+
+    while (num > 0) {
+        char tmp = '0' + (num % 10);
+        num /= 10;
+
+        d[0] = tmp;
+        ns = concatChar(ns, d);
+
+    }
+
+    String reversed = str_reverse(ns);
+    freestr(ns);
+
+    return reversed;
+}
+
+
+bool is_number(String str)
+{
+    // check if number is signed
+    size_t start_idx = (cstr(&str)[0] == '-') ? 1 : 0;
+
+    for (size_t i = start_idx; i < str.length; i++) {
+        char curr = charat(str, i);
+
+        if (!(('0' <= curr) && (curr <= '9')))
+            return false;
+    }
+
+    return true;
+}
+
+
+/*
+value of a decimal A instruction constant, or -1 if it is negative or
+doesn't fit in 15 bits. Stops as soon as it is too big, so a long string of
+digits can't overflow.
+*/
+long constant_value(String str)
+{
+    if (cstr(&str)[0] == '-')
+        return -1;
+
+    long result = 0;
+
+    for (size_t i = 0; i < str.length; i++) {
+        result = result * 10 + (charat(str, i) - '0');
+
+        if (result > 0x7FFF)
+            return -1;
+    }
+
+    return result;
+}
+
+
+// where a job goes when the input is bad, set for as long as asm_run runs
+static jmp_buf *ON_ERROR = NULL;
+static char *ERROR_MESSAGE = NULL;
+static size_t ERROR_SIZE = 0;
+
+
+/* abandon the job with message, its arena frees what it had allocated */
+void exit_with_messages(char *message)
+{
+    if (!ON_ERROR) {
+        printf("%s\n", message);
+        exit(1);
+    }
+
+    if (ERROR_SIZE)
+        snprintf(ERROR_MESSAGE, ERROR_SIZE, "%s", message);
+
+    longjmp(*ON_ERROR, 1);
+}
+
+
+// ------------ GLOBAL CONSTANTS ----------
+
+// holds the count of valid lines of code i.e. not whitespace, comments etc
+size_t LINE_CNT = 0;
+// next available register, starts at 16 as hack uses first 15 by default
+unsigned int NXT_REG = 16;
+
+// the fixed tables, DEST, JUMP, COMP_0, COMP_1 and the PREDEFINED symbols,
+// are generated into tables.h at build time by gen_tables.c
+
+// initialized at run time
+static HT *SYMBOLS = NULL;  // user defined symbols/variables
+static Vector *LABELS = NULL; // (LABEL) names in ROM order, for the symbol map
+static SrcMap *SRC_MAP = NULL; // source line of every ROM word
+static Vector *WORDS = NULL; // machine code as uint16_t, rendered at the end
+
+// words rendered per fwrite() by write_hack()
+#define HACK_CHUNK 512
+
+
+Vector * readlines(FILE *fp)
+{
+    int c;
+    // depending on how the file is saved e.g. as UTF-8, we can have
+    // problems reading characters. For example, a byte order mark may be
+    // automatically added to the first line, so characters come out as
+    // gibberish. Rather than perfectly trying to decode any unicode character,
+    // here we simpply make a one letter null terminated 'string' but casting
+    // the incoming character and assigning its value to the first index of
+    // this array.
+    char d[2];
+
+    Vector *arr = newvec(sizeof(String));
+
+    String line = newstr("");
+
+    d[1] = '\0';
+
+    while ((c = fgetc(fp)) != EOF) {
+        // windows line endings, the '\n' that follows ends the line
+        if (c == '\r')
+            continue;
+
+        if (c == '\n') {
+            String *slot = emplace_back(arr);
+            if (!slot)
+                exit_with_messages("Out of memory");
+
+            *slot = line;
+            line = newstr("");
+            continue;
+        }
+
+        char c2 = (char)c;
+        d[0] = c2;
+
+        line = concatChar(line, d);
+    }
+
+    // an unterminated last line is dropped, like it always was
+    freestr(line);
+
+    return arr;
+
+}
+
+
+void emit_word(uint16_t word)
+{
+    uint16_t *slot = emplace_back(WORDS);
+    if (!slot)
+        exit_with_messages("Out of memory");
+
+    *slot = word;
+}
+
+
+/* render the words a chunk at a time straight into a stack buffer for stdio */
+void write_hack(FILE *fp)
+{
+    char text[HACK_CHUNK * RENDER_LINE];
+    const uint16_t *words = VEC_ITEMS(WORDS, uint16_t);
+
+    for (size_t i = 0; i < WORDS->length; i += HACK_CHUNK) {
+        size_t n = WORDS->length - i < HACK_CHUNK ? WORDS->length - i : HACK_CHUNK;
+        size_t size = render_words(words + i, n, text);
+
+        if (fwrite(text, 1, size, fp) != size)
+            exit_with_messages("Could not write the machine code");
+    }
+}
+
+
+/* the words as they are, for asm_run_words() */
+static void write_words(FILE *fp)
+{
+    if (fwrite(VEC_ITEMS(WORDS, uint16_t), sizeof(uint16_t), WORDS->length, fp) != WORDS->length)
+        exit_with_messages("Could not write the machine code");
+}
+
+
+String get_symbol(String str)
+{
+    int closed = 0;
+    String ns = newstr("");
+
+    for (size_t i = 0; i < str.length; i++) {
+        char curr = charat(str, i);
+
+        if (curr == '(')
+            continue;
+
+        // end of variable
+        // Note: this does not support spaces around brackets
+        if (curr == ' ' || curr == '\n')
+            break;
+
+        // comment
+        if (
+            curr == '/' &&
+            (i + 1 < str.length && cstr(&str)[i + 1] == '/')
+        )
+            break;
+
+        if (curr == ')') {
+            closed = 1;
+            break;
+        }
+
+        ns = concatChar(ns, &curr);
+    }
+
+    if (!closed)
+        exit_with_messages("Invalid variable definition");
+
+    return ns;
+}
+
+
+String get_variable(String str)
+{
+    String ns = newstr("");
+
+    for (size_t i = 0; i < str.length; i++) {
+        char curr = charat(str, i);
+
+        if (curr == '@')
+            continue;
+
+        // end of variable
+        // Note: this does not support spaces between '@' and var name
+        if (curr == ' ' || curr == '\n')
+            break;
+
+        // comment
+        if (
+            curr == '/' &&
+            (i + 1 < str.length && cstr(&str)[i + 1] == '/')
+        )
+            break;
+
+        ns = concatChar(ns, &curr);
+    }
+
+    return ns;
+}
+
+
+void build_symbol_table(Vector *arr)
+{
+    for (size_t i = 0; i < arr->length; i++) {
+        String line = VEC_ITEMS(arr, String)[i];
+
+        if (first(line) == -1)
+            continue;
+
+        line = clean(line);
+
+        if (startswith(line, "(")) {
+            String symbol = get_symbol(line);
+            String address = dec_to_str(LINE_CNT);
+            const char *result = set(SYMBOLS, cstr(&symbol), dupstr(address));
+            freestr(address);
+
+            if (result == NULL) {
+                printf("Did not save: %s", cstr(&symbol));
+                freestr(symbol);
+            } else {
+                String *slot = emplace_back(LABELS);
+                if (!slot)
+                    exit_with_messages("Out of memory");
+
+                // LABELS owns the symbol from here
+                *slot = symbol;
+            }
+
+        } else {
+            LINE_CNT++;
+        }
+
+        freestr(line);
+    }
+}
+
+
+/*
+split "dest=comp;jump" into views of line. Both jump and dest are optional
+and default to "null". Nothing is copied, the views point into line.
+*/
+void _instruction_parser(StrView line, StrView *dest, StrView *comp, StrView *jump)
+{
+    *dest = view("null");
+    *jump = view("null");
+
+    size_t eq = view_find(line, '=');
+    if (eq != VIEW_NPOS) {
+        *dest = subview(line, 0, eq);
+        line = subview(line, eq + 1, VIEW_NPOS);
+    }
+
+    size_t semi = view_find(line, ';');
+    if (semi != VIEW_NPOS) {
+        *jump = subview(line, semi + 1, VIEW_NPOS);
+        line = subview(line, 0, semi);
+    }
+
+    *comp = line;
+}
+
+
+/* 111a cccc ccdd djjj */
+uint16_t instruction_parse(String line)
+{
+    StrView dst, comp, jmp;
+    _instruction_parser(view_str(&line), &dst, &comp, &jmp);
+
+    uint16_t a = 0;
+
+    // the tables are looked up with the views directly, no temporary keys,
+    // and hold each field's bits as a number ready to shift into place
+    const StaticItem *comp_bits = get_static(&COMP_0, comp);
+
+    if (comp_bits == NULL) {
+        a = 1;
+        comp_bits = get_static(&COMP_1, comp);
+    }
+
+    const StaticItem *dst_bits = get_static(&DEST, dst);
+    const StaticItem *jmp_bits = get_static(&JUMP, jmp);
+
+    if (!comp_bits || !dst_bits || !jmp_bits) {
+        char message[128];
+        snprintf(message, sizeof(message), "Invalid instruction: %s", cstr(&line));
+        exit_with_messages(message);
+    }
+
+    return (uint16_t)(
+        0xE000 | a << 12 | comp_bits->value << 6 |
+        dst_bits->value << 3 | jmp_bits->value
+    );
+}
+
+
+/* 0vvv vvvv vvvv vvvv, the value is 15 bits */
+uint16_t variable(String str)
+{
+    long as_num;
+
+    String var = get_variable(str);
+
+    if (is_number(var)) {
+        // anything wider would turn into a C instruction, or not fit at all
+        as_num = constant_value(var);
+
+        if (as_num < 0) {
+            char message[128];
+            snprintf(message, sizeof(message), "Invalid constant: %s", cstr(&str));
+            exit_with_messages(message);
+        }
+
+    } else {
+        // labels are looked up first, so a (LABEL) can shadow a predefined
+        // symbol as it always could
+        const char *sym = get(SYMBOLS, cstr(&var));
+        const StaticItem *predefined = NULL;
+
+        if (sym == NULL)
+            predefined = get_static(&PREDEFINED, view_str(&var));
+
+        if (sym != NULL) {
+            as_num = strtol(sym, NULL, 10);
+
+        } else if (predefined != NULL) {
+            as_num = predefined->value;
+
+        } else {
+            // convert to string to maintain consistency with the rest of our
+            // symbol mapping
+            String address = dec_to_str(NXT_REG);
+            set(SYMBOLS, cstr(&var), dupstr(address));
+            freestr(address);
+
+            // increment the register after using
+            as_num = NXT_REG++;
+        }
+    }
+
+    freestr(var);
+
+    return (uint16_t)as_num;
+}
+
+
+void assemble(Vector *arr)
+{
+    // build the symbol table for user declared variables
+    build_symbol_table(arr);
+    mem_phase("labels");
+
+    // the first pass counted the words, so WORDS grows once
+    if (!reserve(WORDS, LINE_CNT))
+        exit_with_messages("Out of memory");
+
+    for (size_t i = 0; i < arr->length; i++) {
+        String line = VEC_ITEMS(arr, String)[i];
+
+        int first_char_idx = first(line);
+
+        if (first_char_idx == -1) {
+            // comments may carry the .vm/.jack origin of what follows
+            srcmap_directive(SRC_MAP, cstr(&line));
+            continue;
+        }
+        if (cstr(&line)[first_char_idx] == '(') continue;
+
+        String cleaned = clean(line);
+
+        // lines are 1-based, arr holds every line of the file
+        if (srcmap_add(SRC_MAP, (uint32_t)(i + 1)) != 0)
+            exit_with_messages("Out of memory");
+
+        if (startswith(cleaned, "@"))
+            emit_word(variable(cleaned));
+        else
+            emit_word(instruction_parse(cleaned));
+
+        freestr(cleaned);
+    }
+
+    mem_phase("encode");
+}
+
+
+/*
+Write the symbol map that goes with the .hack file: one "<address> <label>"
+line per (LABEL), in ROM order. Anything that wants to attribute a ROM
+address to code (a profiler, a debugger) takes the last label at or below
+the address.
+
+Programs from the VM translator name their labels after the function they
+are in, e.g. Main.fibonacci and Main.fibonacci$IF_TRUE0, so cutting a name
+at '$' gives the VM function.
+*/
+void write_symbols(FILE *fp)
+{
+    for (size_t i = 0; i < LABELS->length; i++) {
+        const char *label = cstr(&VEC_ITEMS(LABELS, String)[i]);
+        fprintf(fp, "%s %s\n", (char *)get(SYMBOLS, label), label);
+    }
+}
+
+
+void init_tables()
+{
+    LINE_CNT = 0;
+    NXT_REG = 16;
+
+    SYMBOLS = create();
+    LABELS = newvec(sizeof(String));
+    WORDS = newvec(sizeof(uint16_t));
+    SRC_MAP = srcmap_new();
+}
+
+
+/*
+Free everything init_tables() and assembling made. Every table owns what is
+in it: SYMBOLS its keys and the addresses (dupstr copies), LABELS and the
+lines their Strings.
+*/
+void free_tables(Vector *lines)
+{
+    for (size_t i = 0; i < lines->length; i++)
+        freestr(VEC_ITEMS(lines, String)[i]);
+    freevec(lines);
+
+    for (size_t i = 0; i < LABELS->length; i++)
+        freestr(VEC_ITEMS(LABELS, String)[i]);
+    freevec(LABELS);
+    freevec(WORDS);
+
+    destroy(SYMBOLS);
+    srcmap_free(SRC_MAP);
+
+    SYMBOLS = NULL;
+    LABELS = NULL;
+    WORDS = NULL;
+    SRC_MAP = NULL;
+}
+
+
+/* one job, the machine code going to code through write_code */
+static int run(FILE *in, FILE *code, void (*write_code)(FILE *), FILE *sym, FILE *map, char *error, size_t error_size)
+{
+    Arena *job = arena_begin();
+    jmp_buf on_error;
+
+    if (setjmp(on_error)) {
+        // the tables are half built, the arena has all of them
+        arena_end(job);
+        ON_ERROR = NULL;
+        mem_on_fail(NULL);
+        return -1;
+    }
+
+    ON_ERROR = &on_error;
+    ERROR_MESSAGE = error;
+    ERROR_SIZE = error_size;
+
+    // a String or table that can't grow ends the job like bad input does
+    mem_on_fail(exit_with_messages);
+
+    init_tables();
+    mem_phase("setup");
+
+    Vector *lines = readlines(in);
+    mem_phase("read");
+
+    assemble(lines);
+
+    write_code(code);
+    write_symbols(sym);
+
+    if (srcmap_write_file(SRC_MAP, map) != 0)
+        exit_with_messages("Could not write the source map");
+
+    mem_phase("write");
+
+    free_tables(lines);
+
+    // reported before the arena ends, so whatever free_tables() missed
+    // still shows up as live here instead of being quietly reclaimed
+    mem_phase("teardown");
+    arena_end(job);
+
+    ON_ERROR = NULL;
+    mem_on_fail(NULL);
+    return 0;
+}
+
+
+int asm_run(FILE *in, FILE *hack, FILE *sym, FILE *map, char *error, size_t error_size)
+{
+    return run(in, hack, write_hack, sym, map, error, error_size);
+}
+
+
+int asm_run_words(FILE *in, FILE *words, FILE *sym, FILE *map, char *error, size_t error_size)
+{
+    return run(in, words, write_words, sym, map, error, error_size);
+}
+
+
+int asm_file(const char *path, char *error, size_t error_size)
+{
+    int status = -1;
+
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        snprintf(error, error_size, "Could not open %s", path);
+        return -1;
+    }
+
+    FILE *hack = fopen(HACK_FILE, "w");
+    FILE *sym = fopen(SYM_FILE, "w");
+    FILE *map = fopen(SRCMAP_FILE, "wb");
+
+    if (!hack || !sym || !map)
+        snprintf(error, error_size, "Could not open the output files");
+    else
+        status = asm_run(in, hack, sym, map, error, error_size);
+
+    FILE *files[] = {in, hack, sym, map};
+
+    for (size_t i = 0; i < sizeof(files) / sizeof(*files); i++) {
+        if (files[i] && fclose(files[i]) != 0 && status == 0) {
+            snprintf(error, error_size, "Could not write the output files");
+            status = -1;
+        }
+    }
+
+    return status;
+}
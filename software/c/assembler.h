@@ -0,0 +1,41 @@
+/* Hack assembler core */
+
+#ifndef ASSEMBLER
+#define ASSEMBLER
+
+#include <stddef.h>
+#include <stdio.h>
+
+
+/*
+Assemble the .asm text read from in: machine code to hack, one 16 character
+line per word, the "<address> <label>" symbol map to sym and the binary
+source map (see srcmap.h) to map. The streams stay open, they belong to the
+caller.
+
+Each call is a job of its own with nothing carried over from the last. On
+bad input it stops, puts the reason in error (if error_size isn't 0) and
+returns -1; whatever was written so far should be thrown away. Returns 0
+otherwise. Not thread safe.
+*/
+int asm_run(FILE *in, FILE *hack, FILE *sym, FILE *map, char *error, size_t error_size);
+/*
+asm_run(), but the machine code goes to words as it is, each word a
+uint16_t in the machine's byte order, for callers that want the words
+rather than .hack text
+*/
+int asm_run_words(FILE *in, FILE *words, FILE *sym, FILE *map, char *error, size_t error_size);
+
+#define HACK_FILE "out.hack"
+#define SYM_FILE "out.sym"
+#define SRCMAP_FILE "out.map"
+
+/*
+what the batch assembler does: asm_run() on the file at path, writing
+HACK_FILE, SYM_FILE and SRCMAP_FILE in the current directory. All three are
+replaced: the symbols and source map give ROM addresses from 0, so code
+appended to an older out.hack would sit at addresses they don't describe.
+*/
+int asm_file(const char *path, char *error, size_t error_size);
+
+#endif
@@ -0,0 +1,112 @@
+/*
+Scaling benchmark for the concurrent hash table.
+
+Every thread runs the same read-mostly mix a symbol table sees while
+assembling: lookups of existing labels, with every 16th operation interning
+a name of its own (a new variable). Reported is the total throughput for
+1, 2, 4, ... threads up to the given maximum (default: online CPUs).
+
+    make bench-chash && ./bench.out [max threads]
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "chash.h"
+
+
+#define KEYS 4096
+#define OPS 2000000
+
+
+static char KEY_NAMES[KEYS][32];
+
+
+typedef struct {
+    CHT *table;
+    int id;
+    size_t sink;   // keeps the lookups from being optimised away
+} Worker;
+
+
+static void * run(void *arg)
+{
+    Worker *w = arg;
+    char name[48];
+    size_t value;
+    unsigned int x = (unsigned int)w->id * 2654435761u + 1;
+
+    for (int i = 0; i < OPS; i++) {
+        // cheap LCG so threads walk the keys in different orders
+        x = x * 1103515245u + 12345u;
+
+        if ((i & 15) == 0) {
+            sprintf(name, "t%d.var%d", w->id, i);
+            w->sink += chash_get_or_insert(w->table, name);
+        } else if (chash_get(w->table, KEY_NAMES[(x >> 8) % KEYS], &value)) {
+            w->sink += value;
+        }
+    }
+
+    return NULL;
+}
+
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+int main(int argc, char *argv[])
+{
+    long max_threads = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1)
+        max_threads = 1;
+
+    for (int i = 0; i < KEYS; i++)
+        sprintf(KEY_NAMES[i], "PongGame.moveBall$IF_TRUE%d", i);
+
+    printf("threads   Mops/s   speedup\n");
+
+    double base = 0;
+    for (long threads = 1; threads <= max_threads; threads *= 2) {
+        CHT *table = chash_create(16);
+        for (int i = 0; i < KEYS; i++)
+            chash_set(table, KEY_NAMES[i], (size_t)i);
+
+        Worker *workers = calloc((size_t)threads, sizeof(*workers));
+        pthread_t *ids = calloc((size_t)threads, sizeof(*ids));
+
+        double start = seconds();
+
+        for (long t = 0; t < threads; t++) {
+            workers[t].table = table;
+            workers[t].id = (int)t;
+            pthread_create(&ids[t], NULL, run, &workers[t]);
+        }
+
+        for (long t = 0; t < threads; t++)
+            pthread_join(ids[t], NULL);
+
+        double elapsed = seconds() - start;
+        double mops = (double)OPS * (double)threads / elapsed / 1e6;
+
+        if (threads == 1)
+            base = mops;
+
+        printf("%7ld %8.2f %8.2fx\n", threads, mops, mops / base);
+
+        free(workers);
+        free(ids);
+        chash_destroy(table);
+    }
+
+    return 0;
+}
@@ -0,0 +1,247 @@
+/*
+Hash function benchmark for HT.
+
+For every key set and hash function this prints the time to hash a key,
+the time for a get() and how far entries sit from their home slot in a
+table built with set(). Key sets:
+
+    real       symbols and labels from the .asm and .vm files given on the
+               command line (default: the programs in projects/6 and 8)
+    generated  VM translator style labels, PongGame.moveBall$IF_TRUE<n>
+    sequential short keys L0, L1, ... which differ only in the last bytes
+
+    make bench-hash && ./bench.out [files...]
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hash.h"
+
+
+#define MAX_KEYS 20000
+#define ROUNDS 200
+#define LINE_MAX 512
+
+
+static const char *DEFAULT_FILES[] = {
+    "../../projects/6/add/Add.asm",
+    "../../projects/6/max/Max.asm",
+    "../../projects/6/rect/Rect.asm",
+    "../../projects/6/pong/Pong.asm",
+    "../../projects/4/fill/Fill.asm",
+    "../../projects/4/mult/Mult.asm",
+    "../../projects/8/FunctionCalls/FibonacciElement/Main.vm",
+    "../../projects/8/FunctionCalls/FibonacciElement/Sys.vm",
+    "../../projects/8/FunctionCalls/NestedCall/Sys.vm",
+    "../../projects/8/FunctionCalls/SimpleFunction/SimpleFunction.vm",
+    "../../projects/8/FunctionCalls/StaticsTest/Class1.vm",
+    "../../projects/8/FunctionCalls/StaticsTest/Class2.vm",
+    "../../projects/8/FunctionCalls/StaticsTest/Sys.vm",
+    "../../projects/8/ProgramFlow/BasicLoop/BasicLoop.vm",
+    "../../projects/8/ProgramFlow/FibonacciSeries/FibonacciSeries.vm",
+};
+
+
+typedef struct {
+    const char *name;
+    char *keys[MAX_KEYS];
+    size_t length;
+    HT *seen;
+} KeySet;
+
+
+static void add_key(KeySet *ks, StrView key)
+{
+    if (key.length == 0 || ks->length == MAX_KEYS || get_view(ks->seen, key))
+        return;
+
+    char *copy = malloc(key.length + 1);
+    memcpy(copy, key.s, key.length);
+    copy[key.length] = '\0';
+
+    set(ks->seen, copy, copy);
+    ks->keys[ks->length++] = copy;
+}
+
+
+/* symbols and labels the assembler would put in its table */
+static void asm_keys(KeySet *ks, StrView line)
+{
+    if (line.length > 1 && line.s[0] == '@' && !(line.s[1] >= '0' && line.s[1] <= '9'))
+        add_key(ks, subview(line, 1, VIEW_NPOS));
+
+    if (line.length > 2 && line.s[0] == '(') {
+        size_t end = view_find(line, ')');
+        if (end != VIEW_NPOS)
+            add_key(ks, subview(line, 1, end - 1));
+    }
+}
+
+
+/* function names, and labels qualified the way the VM translator does */
+static void vm_keys(KeySet *ks, StrView line, char *function)
+{
+    SplitIter it = view_split(line, ' ');
+    StrView command, name;
+
+    if (!split_next(&it, &command) || !split_next(&it, &name))
+        return;
+
+    if (view_eq(command, view("function"))) {
+        snprintf(function, LINE_MAX, "%.*s", (int)name.length, name.s);
+        add_key(ks, name);
+
+    } else if (view_eq(command, view("call"))) {
+        add_key(ks, name);
+
+    } else if (
+        view_eq(command, view("label")) ||
+        view_eq(command, view("goto")) ||
+        view_eq(command, view("if-goto"))
+    ) {
+        char label[2 * LINE_MAX];
+        snprintf(label, sizeof(label), "%s$%.*s", function, (int)name.length, name.s);
+        add_key(ks, view(label));
+    }
+}
+
+
+static void load(KeySet *ks, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("skipping %s, could not open it\n", path);
+        return;
+    }
+
+    bool is_vm = view_suffix(view(path), view(".vm"));
+    char line[LINE_MAX];
+    char function[LINE_MAX] = "";
+
+    while (fgets(line, sizeof(line), fp)) {
+        StrView v = view_trim(view(line));
+
+        size_t comment = view_find_str(v, view("//"));
+        if (comment != VIEW_NPOS)
+            v = view_trim(subview(v, 0, comment));
+
+        if (is_vm)
+            vm_keys(ks, v, function);
+        else
+            asm_keys(ks, v);
+    }
+
+    fclose(fp);
+}
+
+
+static void generate(KeySet *ks, const char *format, size_t count)
+{
+    char key[64];
+
+    for (size_t i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), format, (int)i);
+        add_key(ks, view(key));
+    }
+}
+
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+static void run(KeySet *ks, const char *name, HashFunc fn, uint64_t seed)
+{
+    StrView views[MAX_KEYS];
+    for (size_t i = 0; i < ks->length; i++)
+        views[i] = view(ks->keys[i]);
+
+    // hashing alone
+    uint64_t sink = 0;
+    double start = seconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (size_t i = 0; i < ks->length; i++)
+            sink ^= fn(views[i], seed);
+    double hash_ns = (seconds() - start) * 1e9 / (double)(ROUNDS * ks->length);
+
+    HT *table = create();
+    hash_function(table, fn, seed);
+    for (size_t i = 0; i < ks->length; i++)
+        set(table, ks->keys[i], ks->keys[i]);
+
+    // lookups of every key
+    start = seconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (size_t i = 0; i < ks->length; i++)
+            sink ^= (uint64_t)(uintptr_t)get(table, ks->keys[i]);
+    double get_ns = (seconds() - start) * 1e9 / (double)(ROUNDS * ks->length);
+
+    ProbeStats probes = hash_probe_stats(table);
+
+    printf("  %-12s %7.1f %7.1f %6.2f %4zu  ",
+        name, hash_ns, get_ns, (double)probes.total / (double)probes.entries, probes.max);
+
+    for (size_t i = 0; i < PROBE_BUCKETS; i++)
+        printf(" %5zu", probes.histogram[i]);
+
+    printf("%s\n", sink == 42 ? " " : "");
+}
+
+
+static void report(KeySet *ks)
+{
+    size_t chars = 0;
+    for (size_t i = 0; i < ks->length; i++)
+        chars += strlen(ks->keys[i]);
+
+    printf("\n%s: %zu keys, %.1f bytes on average\n", ks->name, ks->length,
+        ks->length ? (double)chars / (double)ks->length : 0.0);
+    printf("  %-12s %7s %7s %6s %4s   probe length histogram 1..%d+\n",
+        "function", "hash ns", "get ns", "mean", "max", PROBE_BUCKETS);
+
+    if (ks->length == 0)
+        return;
+
+    run(ks, "fnv1a", hash_fnv1a, 0);
+    run(ks, "wy", hash_wy, 0);
+    run(ks, "wy seeded", hash_wy, hash_random_seed());
+}
+
+
+int main(int argc, char *argv[])
+{
+    static KeySet real, generated, sequential;
+
+    real.name = "real";
+    generated.name = "generated";
+    sequential.name = "sequential";
+
+    real.seen = create();
+    generated.seen = create();
+    sequential.seen = create();
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++)
+            load(&real, argv[i]);
+    } else {
+        for (size_t i = 0; i < sizeof(DEFAULT_FILES) / sizeof(*DEFAULT_FILES); i++)
+            load(&real, DEFAULT_FILES[i]);
+    }
+
+    generate(&generated, "PongGame.moveBall$IF_TRUE%d", 10000);
+    generate(&sequential, "L%d", 10000);
+
+    report(&real);
+    report(&generated);
+    report(&sequential);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+Startup benchmark for the assembler's fixed symbol tables.
+
+Compares building DEST, JUMP, COMP_0, COMP_1 and the predefined symbols as
+HTs at startup, the way init_tables() used to, with the const perfect hash
+tables gen_tables.c puts in tables.h. Reported per table set are the time
+and allocations to get the tables ready, and the time for a lookup.
+
+    make bench-startup && ./bench.out
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "hash.h"
+#include "tables.h"
+
+
+#define ROUNDS 2000
+#define LOOKUPS 200
+
+
+static const StaticHT *ASM_TABLES[] = {&DEST, &JUMP, &COMP_0, &COMP_1, &PREDEFINED};
+#define TABLE_COUNT (sizeof(ASM_TABLES) / sizeof(*ASM_TABLES))
+
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+/* the same entries as a table built at run time */
+static HT * build(const StaticHT *table)
+{
+    HT *map = create();
+
+    for (size_t i = 0; i <= table->mask; i++) {
+        const StaticItem *item = &table->slots[i];
+        if (item->key)
+            set(map, (char *)item->key, (void *)&item->value);
+    }
+
+    return map;
+}
+
+
+int main(void)
+{
+    static HT *built[ROUNDS][TABLE_COUNT];
+    size_t keys = 0;
+
+    for (size_t t = 0; t < TABLE_COUNT; t++)
+        for (size_t i = 0; i <= ASM_TABLES[t]->mask; i++)
+            keys += ASM_TABLES[t]->slots[i].key != NULL;
+
+    // the values point into tables.h, which destroy() would try to free, so
+    // the built tables are left for the process to clean up
+    mem_stats_reset();
+    double start = seconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (size_t t = 0; t < TABLE_COUNT; t++)
+            built[r][t] = build(ASM_TABLES[t]);
+    double build_us = (seconds() - start) * 1e6 / ROUNDS;
+    double build_allocs = (double)mem_stats().allocs / ROUNDS;
+
+    // every key of every table, LOOKUPS times over
+    size_t sink = 0;
+    start = seconds();
+    for (int r = 0; r < LOOKUPS; r++)
+        for (size_t t = 0; t < TABLE_COUNT; t++)
+            for (size_t i = 0; i <= ASM_TABLES[t]->mask; i++)
+                if (ASM_TABLES[t]->slots[i].key)
+                    sink += (size_t)get(built[0][t], ASM_TABLES[t]->slots[i].key);
+    double get_ns = (seconds() - start) * 1e9 / (double)(LOOKUPS * keys);
+
+    start = seconds();
+    for (int r = 0; r < LOOKUPS; r++)
+        for (size_t t = 0; t < TABLE_COUNT; t++)
+            for (size_t i = 0; i <= ASM_TABLES[t]->mask; i++)
+                if (ASM_TABLES[t]->slots[i].key)
+                    sink += (size_t)get_static(ASM_TABLES[t], view(ASM_TABLES[t]->slots[i].key));
+    double static_ns = (seconds() - start) * 1e9 / (double)(LOOKUPS * keys);
+
+    printf("%zu keys in %zu tables\n", keys, TABLE_COUNT);
+    printf("  %-10s %10s %10s %10s\n", "tables", "setup us", "allocs", "get ns");
+    printf("  %-10s %10.2f %10.1f %10.1f\n", "runtime", build_us, build_allocs, get_ns);
+    printf("  %-10s %10.2f %10.1f %10.1f\n", "generated", 0.0, 0.0, static_ns);
+    printf("%s", sink == 42 ? " \n" : "");
+
+    return 0;
+}
@@ -0,0 +1,308 @@
+/* Concurrent hash table implementation. */
+
+// pthreads are POSIX, not C99
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chash.h"
+#include "strview.h"
+
+
+// shards are picked by the top bits of the hash, slots by the bottom ones
+#define CHT_SHARD_BITS 4
+#define CHT_SHARDS (1 << CHT_SHARD_BITS)
+#define CHT_INIT_SIZE 16
+#define OOM "-------- OUT OF MEMORY ---------\n"
+
+
+typedef struct {
+    char *key;     // NULL until the slot is published, then never changes
+    size_t value;
+} Slot;
+
+
+typedef struct Table {
+    size_t size;             // power of two, at most half full
+    struct Table *retired;   // table this one replaced, freed by chash_destroy
+    Slot slots[];
+} Table;
+
+
+typedef struct {
+    pthread_mutex_t lock;    // held by writers only
+    Table *table;            // swapped atomically on resize
+    size_t length;
+} Shard;
+
+
+struct CHT {
+    Shard shards[CHT_SHARDS];
+    size_t next_id;          // next ID for chash_get_or_insert
+};
+
+
+static void myprint(char *func_name, char *ptr_name, char *message)
+{
+    printf("(%s)-(%s): %s", func_name, ptr_name, message);
+}
+
+
+static uint64_t hash(const char *key)
+{
+    return view_hash(view(key));
+}
+
+
+static Shard * shard_of(CHT *cht, uint64_t h)
+{
+    return &cht->shards[h >> (64 - CHT_SHARD_BITS)];
+}
+
+
+static Table * new_table(size_t size)
+{
+    // must start zeroed, an empty slot is one with a NULL key
+    Table *t = calloc(1, sizeof(*t) + sizeof(Slot) * size);
+    if (!t) {
+        myprint("new_table", "t", OOM);
+        return NULL;
+    }
+
+    t->size = size;
+    return t;
+}
+
+
+/* lock-free probe, NULL if key is not in t */
+static Slot * find(Table *t, const char *key, uint64_t h)
+{
+    size_t mask = t->size - 1;
+    size_t idx = (size_t)h & mask;
+
+    // tables are never full, so there is always an empty slot to stop at
+    for (;;) {
+        char *curr = __atomic_load_n(&t->slots[idx].key, __ATOMIC_ACQUIRE);
+
+        if (curr == NULL)
+            return NULL;
+
+        if (strcmp(curr, key) == 0)
+            return &t->slots[idx];
+
+        idx = (idx + 1) & mask;
+    }
+}
+
+
+/* write a new entry into t, the caller holds the shard lock */
+static void place(Table *t, char *key, size_t value, uint64_t h)
+{
+    size_t mask = t->size - 1;
+    size_t idx = (size_t)h & mask;
+
+    while (t->slots[idx].key != NULL)
+        idx = (idx + 1) & mask;
+
+    // value first: once a reader sees the key, the value must be there
+    __atomic_store_n(&t->slots[idx].value, value, __ATOMIC_RELAXED);
+    __atomic_store_n(&t->slots[idx].key, key, __ATOMIC_RELEASE);
+}
+
+
+/* copy the shard into a table twice the size and publish it */
+static Table * grow(Shard *shard)
+{
+    Table *old = shard->table;
+    Table *t = new_table(old->size * 2);
+    if (!t)
+        return NULL;
+
+    // keys are shared with the old table, which nobody writes to again
+    for (size_t i = 0; i < old->size; i++) {
+        Slot curr = old->slots[i];
+        if (curr.key != NULL)
+            place(t, curr.key, curr.value, hash(curr.key));
+    }
+
+    t->retired = old;
+    __atomic_store_n(&shard->table, t, __ATOMIC_RELEASE);
+
+    return t;
+}
+
+
+/* add a key that is not in the shard yet, the caller holds the lock */
+static bool insert(Shard *shard, const char *key, size_t value, uint64_t h)
+{
+    Table *t = shard->table;
+
+    // keep at most half full so probes stay short
+    if ((shard->length + 1) * 2 > t->size) {
+        t = grow(shard);
+        if (!t)
+            return false;
+    }
+
+    size_t len = strlen(key);
+    char *copy = malloc(len + 1);
+    if (!copy) {
+        myprint("insert", "copy", OOM);
+        return false;
+    }
+
+    memcpy(copy, key, len + 1);
+    place(t, copy, value, h);
+
+    __atomic_store_n(&shard->length, shard->length + 1, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+
+CHT * chash_create(size_t first_id)
+{
+    size_t ready = 0;    // shards with a table and an initialised lock
+
+    CHT *cht = calloc(1, sizeof(*cht));
+    if (!cht)
+        goto error;
+
+    cht->next_id = first_id;
+
+    for (; ready < CHT_SHARDS; ready++) {
+        Shard *shard = &cht->shards[ready];
+
+        shard->table = new_table(CHT_INIT_SIZE);
+        if (!shard->table)
+            goto error;
+
+        if (pthread_mutex_init(&shard->lock, NULL) != 0) {
+            free(shard->table);
+            goto error;
+        }
+    }
+
+    return cht;
+
+error:
+    myprint("chash_create", "cht", OOM);
+
+    // only what was set up, the rest of the shards were never touched
+    for (size_t i = 0; cht && i < ready; i++) {
+        free(cht->shards[i].table);
+        pthread_mutex_destroy(&cht->shards[i].lock);
+    }
+
+    free(cht);
+    return NULL;
+}
+
+
+bool chash_get(CHT *cht, const char *key, size_t *value)
+{
+    uint64_t h = hash(key);
+    Table *t = __atomic_load_n(&shard_of(cht, h)->table, __ATOMIC_ACQUIRE);
+
+    Slot *slot = find(t, key, h);
+    if (!slot)
+        return false;
+
+    *value = __atomic_load_n(&slot->value, __ATOMIC_ACQUIRE);
+    return true;
+}
+
+
+bool chash_set(CHT *cht, const char *key, size_t value)
+{
+    uint64_t h = hash(key);
+    Shard *shard = shard_of(cht, h);
+    bool result = true;
+
+    pthread_mutex_lock(&shard->lock);
+
+    Slot *slot = find(shard->table, key, h);
+    if (slot)
+        __atomic_store_n(&slot->value, value, __ATOMIC_RELEASE);
+    else
+        result = insert(shard, key, value, h);
+
+    pthread_mutex_unlock(&shard->lock);
+
+    return result;
+}
+
+
+size_t chash_get_or_insert(CHT *cht, const char *key)
+{
+    size_t value;
+
+    // the common case, the key is already there
+    if (chash_get(cht, key, &value))
+        return value;
+
+    uint64_t h = hash(key);
+    Shard *shard = shard_of(cht, h);
+
+    pthread_mutex_lock(&shard->lock);
+
+    // another thread may have added it while we waited for the lock
+    Slot *slot = find(shard->table, key, h);
+    if (slot) {
+        value = slot->value;
+    } else {
+        // under the shard lock, so only one thread takes an ID for this key
+        value = __atomic_fetch_add(&cht->next_id, 1, __ATOMIC_RELAXED);
+
+        if (!insert(shard, key, value, h)) {
+            pthread_mutex_unlock(&shard->lock);
+            exit(1);
+        }
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+
+    return value;
+}
+
+
+size_t chash_length(CHT *cht)
+{
+    size_t result = 0;
+
+    for (size_t i = 0; i < CHT_SHARDS; i++)
+        result += __atomic_load_n(&cht->shards[i].length, __ATOMIC_RELAXED);
+
+    return result;
+}
+
+
+void chash_destroy(CHT *cht)
+{
+    if (!cht)
+        return;
+
+    for (size_t i = 0; i < CHT_SHARDS; i++) {
+        Table *t = cht->shards[i].table;
+        if (!t)
+            continue;
+
+        // the current table holds every key, retired ones only share them
+        for (size_t j = 0; j < t->size; j++)
+            free(t->slots[j].key);
+
+        while (t) {
+            Table *retired = t->retired;
+            free(t);
+            t = retired;
+        }
+
+        pthread_mutex_destroy(&cht->shards[i].lock);
+    }
+
+    free(cht);
+}
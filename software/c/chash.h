@@ -0,0 +1,50 @@
+/* Concurrent hash table */
+
+#ifndef CHASH
+#define CHASH
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/*
+A string -> size_t table that any number of threads can share, for symbol
+tables once the tools run on several threads: names to addresses, or names
+to IDs handed out by chash_get_or_insert().
+
+- Reads take no lock. Each shard's slots live in a table that is only ever
+  replaced, never changed under a reader: a resize copies the entries into
+  a bigger table and publishes it with one atomic pointer store. Replaced
+  tables are kept until chash_destroy(), so a reader still probing one is
+  never left with freed memory (RCU with the table's lifetime as the grace
+  period; with doubling, the old tables add up to less than the live one).
+- Writes lock only the shard the key hashes to.
+- Keys are copied and never removed.
+
+Built on pthreads and GCC's __atomic builtins, link with -pthread.
+*/
+typedef struct CHT CHT;
+
+
+/* IDs from chash_get_or_insert() count up from first_id */
+CHT * chash_create(size_t first_id);
+
+/* lock-free, returns true and fills in value if key is present */
+bool chash_get(CHT *, const char *key, size_t *value);
+
+/* insert key or overwrite its value, returns false if out of memory */
+bool chash_set(CHT *, const char *key, size_t value);
+
+/*
+value of key, inserting it with the next ID first if it is missing. However
+many threads race on the same new key, exactly one ID is taken for it and
+every caller gets that one.
+*/
+size_t chash_get_or_insert(CHT *, const char *key);
+
+size_t chash_length(CHT *);
+
+/* not thread safe, every other user must be done with the table */
+void chash_destroy(CHT *);
+
+#endif
@@ -0,0 +1,557 @@
+/* Assembler daemon and client implementation. */
+
+// sockets, fmemopen and open_memstream are POSIX, not C99
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "assembler.h"
+#include "daemon.h"
+#include "hash.h"
+
+
+#define ASMD_BACKLOG 64
+#define ASMD_LINE_MAX 64
+#define ASMD_MAX_INPUT (64 * 1024 * 1024)
+#define ASMD_BUFFER 16384
+#define ASMD_CACHE_SIZE 64
+// bytes of input and outputs the cache holds at most, and the most one
+// entry may take; bigger jobs are answered and not kept
+#define ASMD_CACHE_BYTES (64 * 1024 * 1024)
+#define ASMD_CACHE_ENTRY_MAX (8 * 1024 * 1024)
+
+
+// ---------------- connections ----------------
+
+/*
+buffered reads from a socket, so a request header costs one recv. Reads
+and writes give up once the clock passes deadline, 0 waits forever.
+*/
+typedef struct {
+    int fd;
+    int64_t deadline;    // ms, see now_ms()
+    size_t start;
+    size_t end;
+    char buffer[ASMD_BUFFER];
+} Conn;
+
+
+/* milliseconds on a clock that only goes forward */
+static int64_t now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+
+/* wait for the socket to be readable or writable; -1 past the deadline */
+static int wait_for(Conn *conn, short events)
+{
+    struct pollfd pfd = {conn->fd, events, 0};
+    int n;
+
+    do {
+        int timeout = -1;
+
+        if (conn->deadline) {
+            int64_t left = conn->deadline - now_ms();
+            if (left <= 0)
+                return -1;
+
+            timeout = (int)left;
+        }
+
+        n = poll(&pfd, 1, timeout);
+    } while (n < 0 && errno == EINTR);
+
+    return n > 0 ? 0 : -1;
+}
+
+
+// nothing ready after all, the caller waits again
+#define AGAIN(n) ((n) < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+
+
+static int fill(Conn *conn)
+{
+    ssize_t n;
+
+    // never a blocking recv, which could outlast the deadline
+    do {
+        if (wait_for(conn, POLLIN) != 0)
+            return -1;
+
+        n = recv(conn->fd, conn->buffer, sizeof(conn->buffer), MSG_DONTWAIT);
+    } while (AGAIN(n));
+
+    if (n <= 0)
+        return -1;
+
+    conn->start = 0;
+    conn->end = (size_t)n;
+    return 0;
+}
+
+
+/* next '\n' terminated line, without the '\n'; -1 on EOF or a long line */
+static int read_line(Conn *conn, char *line, size_t max)
+{
+    size_t length = 0;
+
+    for (;;) {
+        if (conn->start == conn->end && fill(conn) != 0)
+            return -1;
+
+        char c = conn->buffer[conn->start++];
+        if (c == '\n')
+            break;
+
+        if (length + 1 == max)
+            return -1;
+
+        line[length++] = c;
+    }
+
+    line[length] = '\0';
+    return 0;
+}
+
+
+static int read_bytes(Conn *conn, char *dest, size_t size)
+{
+    while (size > 0) {
+        if (conn->start == conn->end && fill(conn) != 0)
+            return -1;
+
+        size_t n = conn->end - conn->start;
+        if (n > size)
+            n = size;
+
+        memcpy(dest, conn->buffer + conn->start, n);
+        conn->start += n;
+        dest += n;
+        size -= n;
+    }
+
+    return 0;
+}
+
+
+static int write_all(Conn *conn, const char *data, size_t size)
+{
+    while (size > 0) {
+        if (wait_for(conn, POLLOUT) != 0)
+            return -1;
+
+        // a peer that hung up is an error here, not a SIGPIPE
+        ssize_t n = send(conn->fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (AGAIN(n))
+            continue;
+        if (n <= 0)
+            return -1;
+
+        data += n;
+        size -= (size_t)n;
+    }
+
+    return 0;
+}
+
+
+static int unix_address(const char *path, struct sockaddr_un *addr)
+{
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return -1;
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+
+    return 0;
+}
+
+
+const char * asmd_socket(void)
+{
+    const char *path = getenv("ASMD_SOCKET");
+    return path && *path ? path : ASMD_SOCKET;
+}
+
+
+// ---------------- cache ----------------
+
+/*
+Outputs of the last ASMD_CACHE_SIZE files assembled, oldest replaced first,
+and no more than ASMD_CACHE_BYTES of them. The whole input is kept to
+compare against, so a hash collision can't hand back another file's code.
+Everything here is malloc'ed: it outlives the jobs, and open_memstream()
+gives us malloc'ed buffers anyway.
+*/
+typedef struct {
+    uint64_t hash;
+    char *input;       // NULL for an unused entry
+    size_t size;
+
+    char *output[ASMD_OUTPUTS];
+    size_t output_size[ASMD_OUTPUTS];
+} CacheEntry;
+
+
+static CacheEntry CACHE[ASMD_CACHE_SIZE];
+static size_t CACHE_NEXT = 0;
+static size_t CACHE_BYTES = 0;   // inputs and outputs of every entry
+
+
+static CacheEntry * cache_find(uint64_t hash, const char *input, size_t size)
+{
+    for (size_t i = 0; i < ASMD_CACHE_SIZE; i++) {
+        CacheEntry *entry = &CACHE[i];
+
+        if (
+            entry->input && entry->hash == hash && entry->size == size &&
+            memcmp(entry->input, input, size) == 0
+        )
+            return entry;
+    }
+
+    return NULL;
+}
+
+
+static size_t entry_size(size_t size, const size_t *output_size)
+{
+    for (size_t i = 0; i < ASMD_OUTPUTS; i++)
+        size += output_size[i];
+
+    return size;
+}
+
+
+static void entry_free(CacheEntry *entry)
+{
+    free(entry->input);
+    for (size_t i = 0; i < ASMD_OUTPUTS; i++)
+        free(entry->output[i]);
+
+    memset(entry, 0, sizeof(*entry));
+}
+
+
+static void cache_evict(CacheEntry *entry)
+{
+    if (!entry->input)
+        return;
+
+    CACHE_BYTES -= entry_size(entry->size, entry->output_size);
+    entry_free(entry);
+}
+
+
+/* keeps entry's buffers, or returns false and leaves them to the caller */
+static bool cache_add(CacheEntry *entry)
+{
+    size_t bytes = entry_size(entry->size, entry->output_size);
+
+    if (bytes > ASMD_CACHE_ENTRY_MAX)
+        return false;
+
+    // the ring is in insertion order from CACHE_NEXT on, so this drops
+    // the oldest entries until the new one fits
+    cache_evict(&CACHE[CACHE_NEXT]);
+
+    for (size_t i = 1; CACHE_BYTES + bytes > ASMD_CACHE_BYTES && i < ASMD_CACHE_SIZE; i++)
+        cache_evict(&CACHE[(CACHE_NEXT + i) % ASMD_CACHE_SIZE]);
+
+    CACHE[CACHE_NEXT] = *entry;
+    CACHE_NEXT = (CACHE_NEXT + 1) % ASMD_CACHE_SIZE;
+    CACHE_BYTES += bytes;
+
+    return true;
+}
+
+
+// ---------------- server ----------------
+
+/*
+Connections are served one at a time, so a client that stops sending or
+reading, or only trickles, is dropped once this runs out rather than
+holding up the rest: one whole request has ASMD_TIMEOUT_MS to arrive, and
+its reply as long again to be read.
+*/
+static void start_deadline(Conn *conn)
+{
+    conn->deadline = now_ms() + ASMD_TIMEOUT_MS;
+}
+
+
+static int send_error(Conn *conn, const char *message)
+{
+    char header[ASMD_LINE_MAX];
+    size_t length = strlen(message);
+
+    start_deadline(conn);
+
+    snprintf(header, sizeof(header), "error %zu\n", length);
+
+    if (write_all(conn, header, strlen(header)) != 0)
+        return -1;
+
+    return write_all(conn, message, length);
+}
+
+
+static int send_outputs(Conn *conn, const CacheEntry *entry)
+{
+    char header[ASMD_LINE_MAX];
+
+    start_deadline(conn);
+
+    snprintf(header, sizeof(header), "ok %zu %zu %zu\n",
+        entry->output_size[0], entry->output_size[1], entry->output_size[2]);
+
+    if (write_all(conn, header, strlen(header)) != 0)
+        return -1;
+
+    for (size_t i = 0; i < ASMD_OUTPUTS; i++) {
+        if (write_all(conn, entry->output[i], entry->output_size[i]) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+
+/* input is malloc'ed, and either cached or freed here */
+static int assemble(Conn *conn, char *input, size_t size)
+{
+    StrView key = {input, size};
+    uint64_t hash = hash_wy(key, 0);
+
+    CacheEntry *entry = cache_find(hash, input, size);
+    if (entry) {
+        free(input);
+        return send_outputs(conn, entry);
+    }
+
+    CacheEntry job = {hash, input, size, {NULL, NULL, NULL}, {0, 0, 0}};
+    FILE *streams[ASMD_OUTPUTS];
+    char error[256] = "Out of memory";
+    int status = -1;
+
+    FILE *in = fmemopen(input, size, "r");
+
+    for (size_t i = 0; i < ASMD_OUTPUTS; i++)
+        streams[i] = open_memstream(&job.output[i], &job.output_size[i]);
+
+    if (in && streams[0] && streams[1] && streams[2])
+        status = asm_run(in, streams[0], streams[1], streams[2], error, sizeof(error));
+
+    if (in)
+        fclose(in);
+
+    // closing a memstream is what leaves the final buffer and size behind
+    for (size_t i = 0; i < ASMD_OUTPUTS; i++) {
+        if (streams[i] && fclose(streams[i]) != 0)
+            status = -1;
+    }
+
+    if (status != 0) {
+        entry_free(&job);
+        return send_error(conn, error);
+    }
+
+    status = send_outputs(conn, &job);
+
+    // the cache takes the buffers over, unless the job is too big to keep
+    if (!cache_add(&job))
+        entry_free(&job);
+
+    return status;
+}
+
+
+static void serve_connection(int fd)
+{
+    static Conn conn;
+    char line[ASMD_LINE_MAX];
+    char command[16];
+    size_t size;
+
+    conn.fd = fd;
+    conn.start = conn.end = 0;
+
+    for (;;) {
+        start_deadline(&conn);
+
+        if (read_line(&conn, line, sizeof(line)) != 0)
+            return;
+
+        if (sscanf(line, "%15s %zu", command, &size) != 2 || size > ASMD_MAX_INPUT) {
+            send_error(&conn, "Bad request");
+            return;
+        }
+
+        char *input = malloc(size ? size : 1);
+        if (!input || read_bytes(&conn, input, size) != 0) {
+            free(input);
+            return;
+        }
+
+        int status;
+
+        if (strcmp(command, "assemble") == 0) {
+            status = assemble(&conn, input, size);
+        } else {
+            free(input);
+            status = send_error(&conn, "Unsupported command, only assemble is implemented");
+        }
+
+        if (status != 0)
+            return;
+    }
+}
+
+
+int asmd_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    if (unix_address(path, &addr) != 0)
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    // a daemon that answers is alive, its socket is not ours to take
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        close(fd);
+        errno = EADDRINUSE;
+        return -1;
+    }
+
+    close(fd);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    // a socket file left behind by a daemon that died
+    unlink(path);
+
+    if (
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, ASMD_BACKLOG) != 0
+    ) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+void asmd_serve(int listen_fd, size_t max_connections)
+{
+    for (size_t served = 0; max_connections == 0 || served < max_connections; served++) {
+        int fd = accept(listen_fd, NULL, NULL);
+
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        serve_connection(fd);
+        close(fd);
+    }
+}
+
+
+// ---------------- client ----------------
+
+int asmd_request(const char *path, const char *command, const char *input, size_t size, AsmdReply *reply)
+{
+    static Conn conn;
+    struct sockaddr_un addr;
+    char line[ASMD_LINE_MAX];
+
+    memset(reply, 0, sizeof(*reply));
+
+    if (unix_address(path, &addr) != 0)
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        goto error;
+
+    // the client waits as long as the daemon takes
+    conn.fd = fd;
+    conn.deadline = 0;
+    conn.start = conn.end = 0;
+
+    snprintf(line, sizeof(line), "%s %zu\n", command, size);
+
+    if (write_all(&conn, line, strlen(line)) != 0 || write_all(&conn, input, size) != 0)
+        goto error;
+
+    if (read_line(&conn, line, sizeof(line)) != 0)
+        goto error;
+
+    size_t length;
+
+    if (sscanf(line, "error %zu", &length) == 1) {
+        reply->error = malloc(length + 1);
+        if (!reply->error || read_bytes(&conn, reply->error, length) != 0)
+            goto error;
+
+        reply->error[length] = '\0';
+
+    } else if (sscanf(line, "ok %zu %zu %zu", &reply->size[0], &reply->size[1], &reply->size[2]) == 3) {
+        reply->ok = 1;
+
+        for (size_t i = 0; i < ASMD_OUTPUTS; i++) {
+            reply->output[i] = malloc(reply->size[i] ? reply->size[i] : 1);
+
+            if (!reply->output[i] || read_bytes(&conn, reply->output[i], reply->size[i]) != 0)
+                goto error;
+        }
+
+    } else {
+        goto error;
+    }
+
+    close(fd);
+    return 0;
+
+error:
+    asmd_reply_free(reply);
+    close(fd);
+    return -1;
+}
+
+
+void asmd_reply_free(AsmdReply *reply)
+{
+    for (size_t i = 0; i < ASMD_OUTPUTS; i++)
+        free(reply->output[i]);
+
+    free(reply->error);
+    memset(reply, 0, sizeof(*reply));
+}
@@ -0,0 +1,73 @@
+/* Assembler daemon and the client side of its protocol */
+
+#ifndef DAEMON
+#define DAEMON
+
+#include <stddef.h>
+
+
+/*
+asmd keeps one process around to assemble for every build step, so each
+request skips process start up, and a file it has seen before is answered
+from a cache keyed by a hash of its contents.
+
+Protocol, over a Unix domain stream socket, any number of requests per
+connection:
+
+    request   "<command> <size>\n" then size bytes of input
+    reply     "ok <hack size> <sym size> <map size>\n" then the three outputs
+              "error <size>\n" then a message of that many bytes
+
+The only command is "assemble", the outputs are what the batch assembler
+writes to out.hack, out.sym and out.map. There is no VM translator or
+compiler in C yet, "translate" and "compile" get an error.
+
+What is kept between requests is the cache and nothing else. The fixed
+tables, predefined symbols included, are already interned: tables.h builds
+them at compile time, so no process has any set up to skip. User symbols
+are not interned across requests on purpose. They and their addresses
+belong to one program and each job frees them with its arena (see
+asm_run()). A pool shared between jobs would be the one thing that outlives
+them, growing with every name any client ever used, to save a short copy
+per symbol.
+*/
+
+// socket used unless ASMD_SOCKET is set in the environment
+#define ASMD_SOCKET "/tmp/hack-asm.sock"
+#define ASMD_OUTPUTS 3
+
+// the time a request has to arrive, and its reply to be read, before the
+// connection is closed
+#define ASMD_TIMEOUT_MS 1000
+
+const char * asmd_socket(void);
+
+/*
+server: bind and listen on path, replacing a stale socket file. -1 on
+error, with errno EADDRINUSE if a daemon is already answering on path.
+*/
+int asmd_listen(const char *path);
+/*
+answer connections one at a time, forever if max_connections is 0. A
+whole request has to arrive within ASMD_TIMEOUT_MS, however its bytes are
+spread out, and its reply be read within as long again, so a stalled or
+trickling client holds up the others for at most that.
+*/
+void asmd_serve(int listen_fd, size_t max_connections);
+
+
+typedef struct {
+    int ok;                            // 0 for an error reply
+    char *output[ASMD_OUTPUTS];        // hack, sym, map; malloc'ed
+    size_t size[ASMD_OUTPUTS];
+    char *error;                       // NUL terminated, when !ok
+} AsmdReply;
+
+/*
+client: send one request to the daemon at path. Returns -1 if there is no
+daemon to talk to or the connection fails, 0 once reply is filled in.
+*/
+int asmd_request(const char *path, const char *command, const char *input, size_t size, AsmdReply *reply);
+void asmd_reply_free(AsmdReply *);
+
+#endif
@@ -0,0 +1,215 @@
+/*
+Generates tables.h, the assembler's fixed symbol tables as const perfect
+hash tables (StaticHT, see hash.h).
+
+For every table this picks the smallest power of two slot count and a seed
+for hash_wy() that give each key a slot of its own, then prints the slots
+as a const array. The codes are written below the way the Hack spec gives
+them, bits for the instruction fields and decimal for the addresses, and
+go out as plain numbers. Run by the Makefile before building the assembler:
+
+    ./gen.out > tables.h
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+
+
+// seeds to try at one size before doubling it
+#define MAX_SEEDS 1000000
+#define MAX_SLOTS 256
+
+
+typedef struct {
+    const char *key;
+    const char *code;    // in the base of its table
+} Entry;
+
+
+typedef struct {
+    const char *name;    // name of the StaticHT in the generated header
+    const Entry *items;
+    size_t length;
+    int base;            // of the codes
+} TableDef;
+
+
+// ------------- Symbol tables ------------
+// the basic asm -> machine code symbols, hard coded
+
+static const Entry DEST[] = {
+    {"null", "000"},
+    {"M", "001"},
+    {"D", "010"},
+    {"MD", "011"},
+    {"A", "100"},
+    {"AM", "101"},
+    {"AD", "110"},
+    {"AMD", "111"},
+};
+
+
+static const Entry JUMP[] = {
+    {"null", "000"},
+    {"JGT", "001"},
+    {"JEQ", "010"},
+    {"JGE", "011"},
+    {"JLT", "100"},
+    {"JNE", "101"},
+    {"JLE", "110"},
+    {"JMP", "111"},
+};
+
+
+// op codes for when instruction starts with 0, i.e. a = 0
+static const Entry COMP_0[] = {
+    {"0", "101010"},
+    {"1", "111111"},
+    {"-1", "111010"},
+    {"D", "001100"},
+    {"A", "110000"},
+    {"!D", "001101"},
+    {"!A", "110001"},
+    {"-D", "001111"},
+    {"-A", "110011"},
+    {"D+1", "011111"},
+    {"A+1", "110111"},
+    {"D-1", "001110"},
+    {"A-1", "110010"},
+    {"D+A", "000010"},
+    {"D-A", "010011"},
+    {"A-D", "000111"},
+    {"D&A", "000000"},
+    {"D|A", "010101"},
+};
+
+
+// op codes for when instruction starts with 1, i.e. a = 1
+static const Entry COMP_1[] = {
+    {"M", "110000"},
+    {"!M", "110001"},
+    {"-M", "110011"},
+    {"M+1", "110111"},
+    {"M-1", "110010"},
+    {"D+M", "000010"},
+    {"D-M", "010011"},
+    {"M-D", "000111"},
+    {"D&M", "000000"},
+    {"D|M", "010101"},
+};
+
+
+static const Entry PREDEFINED[] = {
+    // base registers on CPU
+    {"R0", "0"},
+    {"R1", "1"},
+    {"R2", "2"},
+    {"R3", "3"},
+    {"R4", "4"},
+    {"R5", "5"},
+    {"R6", "6"},
+    {"R7", "7"},
+    {"R8", "8"},
+    {"R9", "9"},
+    {"R10", "10"},
+    {"R11", "11"},
+    {"R12", "12"},
+    {"R13", "13"},
+    {"R14", "14"},
+    {"R15", "15"},
+
+    // variables use by the jack VM
+    {"SP", "0"},
+    {"LCL", "1"},
+    {"ARG", "2"},
+    {"THIS", "3"},
+    {"THAT", "4"},
+
+    // peripherals
+    {"SCREEN", "16384"},
+    {"KBD", "24576"},
+};
+
+
+#define TABLE(name, base) {#name, name, sizeof(name) / sizeof(*name), base}
+
+static const TableDef TABLES[] = {
+    TABLE(DEST, 2),
+    TABLE(JUMP, 2),
+    TABLE(COMP_0, 2),
+    TABLE(COMP_1, 2),
+    TABLE(PREDEFINED, 10),
+};
+
+
+/* true if seed sends every key of def to a different one of size slots */
+static bool is_perfect(const TableDef *def, size_t size, uint64_t seed, int *slot_of)
+{
+    char taken[MAX_SLOTS];
+    memset(taken, 0, size);
+
+    for (size_t i = 0; i < def->length; i++) {
+        size_t slot = (size_t)(hash_wy(view(def->items[i].key), seed) & (size - 1));
+
+        if (taken[slot])
+            return false;
+
+        taken[slot] = 1;
+        slot_of[i] = (int)slot;
+    }
+
+    return true;
+}
+
+
+static void generate(const TableDef *def)
+{
+    int slot_of[MAX_SLOTS];
+    size_t size = 1;
+
+    while (size < def->length)
+        size *= 2;
+
+    for (; size <= MAX_SLOTS; size *= 2) {
+        for (uint64_t seed = 0; seed < MAX_SEEDS; seed++) {
+            if (!is_perfect(def, size, seed, slot_of))
+                continue;
+
+            const Entry *slots[MAX_SLOTS] = {NULL};
+            for (size_t i = 0; i < def->length; i++)
+                slots[slot_of[i]] = &def->items[i];
+
+            printf("static const StaticItem %s_SLOTS[%zu] = {\n", def->name, size);
+            for (size_t i = 0; i < size; i++) {
+                if (slots[i])
+                    printf("    {\"%s\", %ld},\n", slots[i]->key, strtol(slots[i]->code, NULL, def->base));
+                else
+                    printf("    {NULL, 0},\n");
+            }
+            printf("};\n\n");
+
+            printf("static const StaticHT %s = {%s_SLOTS, %zu, %lluULL};\n\n\n",
+                def->name, def->name, size - 1, (unsigned long long)seed);
+            return;
+        }
+    }
+
+    fprintf(stderr, "gen_tables: no perfect hash for %s\n", def->name);
+    exit(1);
+}
+
+
+int main(void)
+{
+    printf("/* Generated by gen_tables.c, do not edit. */\n\n");
+    printf("#ifndef TABLES\n#define TABLES\n\n#include \"hash.h\"\n\n\n");
+
+    for (size_t i = 0; i < sizeof(TABLES) / sizeof(*TABLES); i++)
+        generate(&TABLES[i]);
+
+    printf("#endif\n");
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+CPython bindings for the assembler core, so the Python toolchain can use it:
+
+    import hackasm
+    words = hackasm.assemble(open("Max.asm", "rb").read())  # array('H')
+    labels = hackasm.symbols()
+
+Built with `make pymodule`, which puts hackasm.*.so next to asm.py.
+*/
+#define PY_SSIZE_T_CLEAN
+// Python.h has to come first, it sets the feature macros (POSIX included)
+#include <Python.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler.h"
+
+
+#define OUTPUTS 3
+
+// the array module, for the words assemble() returns
+static PyObject *ARRAY = NULL;
+
+// the symbol map written by the last successful assemble()
+static char *LAST_SYMBOLS = NULL;
+static size_t LAST_SYMBOLS_SIZE = 0;
+
+
+static PyObject * assemble(PyObject *self, PyObject *args)
+{
+    Py_buffer source;
+    (void)self;
+
+    if (!PyArg_ParseTuple(args, "y*:assemble", &source))
+        return NULL;
+
+    char *output[OUTPUTS] = {NULL, NULL, NULL};
+    size_t size[OUTPUTS] = {0, 0, 0};
+    FILE *streams[OUTPUTS];
+    char error[256] = "Out of memory";
+    int status = -1;
+
+    FILE *in = fmemopen(source.buf, (size_t)source.len, "r");
+
+    for (size_t i = 0; i < OUTPUTS; i++)
+        streams[i] = open_memstream(&output[i], &size[i]);
+
+    if (in && streams[0] && streams[1] && streams[2])
+        status = asm_run_words(in, streams[0], streams[1], streams[2], error, sizeof(error));
+
+    if (in)
+        fclose(in);
+
+    // closing a memstream is what leaves the final buffer and size behind
+    for (size_t i = 0; i < OUTPUTS; i++) {
+        if (streams[i] && fclose(streams[i]) != 0)
+            status = -1;
+    }
+
+    PyBuffer_Release(&source);
+
+    PyObject *result = NULL;
+
+    if (status != 0) {
+        PyErr_SetString(PyExc_ValueError, error);
+    } else {
+        // array('H', bytes) copies the words in as they are, native order
+        PyObject *words = PyBytes_FromStringAndSize(output[0], (Py_ssize_t)size[0]);
+
+        if (words) {
+            result = PyObject_CallMethod(ARRAY, "array", "sO", "H", words);
+            Py_DECREF(words);
+        }
+    }
+
+    if (result) {
+        // keep the symbol map for symbols()
+        free(LAST_SYMBOLS);
+        LAST_SYMBOLS = output[1];
+        LAST_SYMBOLS_SIZE = size[1];
+        output[1] = NULL;
+    }
+
+    for (size_t i = 0; i < OUTPUTS; i++)
+        free(output[i]);
+
+    return result;
+}
+
+
+/* "<address> <label>" lines into {label: address}, both str like asm.py */
+static PyObject * symbols(PyObject *self, PyObject *unused)
+{
+    (void)self;
+    (void)unused;
+
+    PyObject *table = PyDict_New();
+    if (!table)
+        return NULL;
+
+    const char *line = LAST_SYMBOLS;
+    const char *end = LAST_SYMBOLS + LAST_SYMBOLS_SIZE;
+
+    while (line && line < end) {
+        const char *newline = memchr(line, '\n', (size_t)(end - line));
+        const char *space = memchr(line, ' ', (size_t)(end - line));
+
+        if (!newline || !space || space > newline)
+            break;
+
+        PyObject *address = PyUnicode_FromStringAndSize(line, space - line);
+        PyObject *label = PyUnicode_FromStringAndSize(space + 1, newline - space - 1);
+
+        int failed = !address || !label || PyDict_SetItem(table, label, address) != 0;
+
+        Py_XDECREF(address);
+        Py_XDECREF(label);
+
+        if (failed) {
+            Py_DECREF(table);
+            return NULL;
+        }
+
+        line = newline + 1;
+    }
+
+    return table;
+}
+
+
+static PyMethodDef METHODS[] = {
+    {
+        "assemble", assemble, METH_VARARGS,
+        "assemble(source: bytes) -> array('H')\n\n"
+        "Assemble Hack assembly into its 16 bit machine code words.\n"
+        "Raises ValueError on invalid input."
+    },
+    {
+        "symbols", symbols, METH_NOARGS,
+        "symbols() -> dict[str, str]\n\n"
+        "Labels of the last successful assemble(), name to ROM address."
+    },
+    {NULL, NULL, 0, NULL},
+};
+
+
+static struct PyModuleDef MODULE = {
+    PyModuleDef_HEAD_INIT,
+    "hackasm",
+    "The C Hack assembler.",
+    -1,
+    METHODS,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+
+
+PyMODINIT_FUNC PyInit_hackasm(void)
+{
+    if (!ARRAY && !(ARRAY = PyImport_ImportModule("array")))
+        return NULL;
+
+    return PyModule_Create(&MODULE);
+}
@@ -1,21 +1,47 @@
 /* Hash table implementation. */
 
+// mmap for reading exported tables is POSIX, not C99
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "hash.h"
 
 typedef struct {
-    char *key;  // key will be NULL if slot is empty
+    char *key;
     void *value;
 } Item;
 
 
+/*
+Laid out like Python's compact dict: the entries sit in a dense array in
+insertion order, and a separate sparse index of slots holds, for each slot,
+the number of the entry there. Probing happens in the index, iteration is a
+walk over the entries.
+
+Entries are numbered below 3/4 of the slot count, so each slot is the
+narrowest integer that fits: 1 byte up to 256 slots, 2 up to 65536, else 4.
+An empty slot is all ones.
+*/
 struct HT {
-    size_t length;
-    size_t _total_size;
+    size_t length;       // entries in use
+    size_t _total_size;  // slots in the index, a power of two
+    size_t growth;       // power of two _total_size is multiplied by when resizing
 
-    Item *items;
+    HashFunc hash_fn;
+    uint64_t seed;
+
+    void *index;         // _total_size slots of width bytes
+    size_t width;
+
+    Item *items;         // dense entries, room for _total_size * 3/4
 };
 
 
@@ -24,11 +50,20 @@ struct HT {
 #define FNV_OFFSET 14695981039346656037UL
 #define FNV_PRIME 1099511628211UL
 
+// wyhash's default secret, odd constants with well spread bits
+#define WY0 0xa0761d6478bd642fULL
+#define WY1 0xe7037ed1a0b428dbULL
+#define WY2 0x8ebc6af09c88c6e3ULL
+
 #define HT_INIT_SIZE 16
+#define HT_MIN_SIZE 4
+#define HT_GROWTH 2
+#define HT_HASH hash_fnv1a
 #define OOM "-------- OUT OF MEMORY ---------"
 
-// declare static functions
-char * _set(Item *, size_t, char *, void *, size_t *);
+#define HT_EMPTY ((size_t)-1)
+#define HT_FILE_MAGIC "HTEX"
+#define HT_FILE_VERSION 1
 
 
 static void myprint(char *func_name, char *ptr_name, char *message)
@@ -37,26 +72,26 @@ static void myprint(char *func_name, char *ptr_name, char *message)
 }
 
 
-int issame(const char w1[], const char w2[]) {
-
-    while (*w1 != '\0' && *w2 != '\0' && *w1 == *w2) {
-        w1++;
-        w2++;
-    }
+/* strdup is POSIX rather than C99, so keep our own copy */
+static char * copy_key(const char *key)
+{
+    size_t len = strlen(key);
 
-    if (*w1 != '\0' || *w2 != '\0')
-        return 0;
+    char *result = mem_alloc(sizeof(*result) * (len + 1));
+    if (!result)
+        return NULL;
 
-    return 1;
+    return memcpy(result, key, len + 1);
 }
 
 
-static uint64_t hash(const char *key)
+uint64_t hash_fnv1a(StrView key, uint64_t seed)
 {
-    uint64_t h = FNV_OFFSET;
+    // with seed 0 this is plain FNV-1a, which view_hash() is
+    uint64_t h = FNV_OFFSET ^ seed;
 
-    for (const char *p = key; *p; p++) {
-        h ^= (uint64_t)(unsigned char)(*p);
+    for (size_t i = 0; i < key.length; i++) {
+        h ^= (uint64_t)(unsigned char)key.s[i];
         h *= FNV_PRIME;
     }
 
@@ -64,97 +99,319 @@ static uint64_t hash(const char *key)
 }
 
 
-void _destroy_item(Item *item)
+/* 64x64 -> 128 bit multiply, returned as its two halves */
+static void mum(uint64_t *a, uint64_t *b)
 {
-    if (!item->value || !item->key)
-        return;
+    // done in 32 bit pieces, C99 has no 128 bit integer
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t carry = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+}
 
-    free((void *)item->key);
-    free((void *)item->value);
 
-    // set key to null
-    item->key = NULL;
+static uint64_t mix(uint64_t a, uint64_t b)
+{
+    mum(&a, &b);
+    return a ^ b;
 }
 
 
-void destroy(HT *hash)
+// unaligned little pieces of the key, memcpy compiles to a single load
+static uint64_t read8(const char *p)
 {
-    if (!hash || !hash->items)
-        return;
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
 
-    Item *tmp = hash->items;
-    for (size_t i = 0; i < hash->length; i++, hash->items++)
-        _destroy_item(hash->items);
 
-    free(tmp);
-    free(hash);
+static uint64_t read4(const char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
 }
 
 
-static void _resize(HT *ht, size_t new_size)
+uint64_t hash_wy(StrView key, uint64_t seed)
 {
-    Item *tmp = malloc(sizeof(*tmp) * new_size);
+    const char *p = key.s;
+    size_t len = key.length;
+    uint64_t a, b;
+
+    seed ^= mix(seed ^ WY0, WY1);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            // two overlapping reads from each end cover 4..16 bytes
+            size_t mid = (len >> 3) << 2;
+            a = (read4(p) << 32) | read4(p + mid);
+            b = (read4(p + len - 4) << 32) | read4(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = ((uint64_t)(unsigned char)p[0] << 16)
+                | ((uint64_t)(unsigned char)p[len >> 1] << 8)
+                | (uint64_t)(unsigned char)p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        // 16 bytes a round, a word at a time
+        size_t i = len;
+        while (i > 16) {
+            seed = mix(read8(p) ^ WY1, read8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
 
-    if (!tmp) {
-        myprint("_resize", "tmp", OOM);
-        exit(1);
+        // the last 16 bytes, overlapping what the loop already took
+        a = read8(p + i - 16);
+        b = read8(p + i - 8);
     }
 
-    // loop through the array and re-hash all entries in new mem block
-    // we do ht->_total_size / 2 because we want to go through the previous
-    // items array, which is half the size and we dont want to go out of
-    // bounds. We do the division here because the new size has already been
-    // set externally.
-    for (size_t i = 0; i < (ht->_total_size); i++) {
-        Item curr = ht->items[i];
-        if (curr.key == NULL)
-            continue;
+    a ^= WY1;
+    b ^= seed;
+    mum(&a, &b);
 
-        if (!_set(tmp, new_size, curr.key, curr.value, NULL))
-            printf("Issue rehashing key - %s\n", curr.key);
+    return mix(a ^ WY0 ^ len, b ^ WY2);
+}
+
+
+uint64_t hash_random_seed(void)
+{
+    uint64_t seed = 0;
+
+    FILE *fp = fopen("/dev/urandom", "rb");
+    if (fp) {
+        if (fread(&seed, sizeof(seed), 1, fp) != 1)
+            seed = 0;
+        fclose(fp);
     }
 
-    free(ht->items);
+    // no urandom: the clock and an address are better than nothing
+    if (seed == 0)
+        seed = mix((uint64_t)time(NULL) ^ WY0, (uint64_t)(uintptr_t)&seed ^ WY1);
 
-    ht->items = tmp;
+    return seed;
+}
+
+
+static uint64_t hash(HT *ht, const char *key)
+{
+    return ht->hash_fn(view(key), ht->seed);
+}
+
+
+/* entries a table with size slots has room for */
+static size_t _capacity(size_t size)
+{
+    return size / 4 * 3;
+}
+
+
+static size_t _width(size_t size)
+{
+    if (size <= 256)
+        return 1;
+
+    if (size <= 65536)
+        return 2;
+
+    return 4;
+}
+
+
+/* entry number in slot i, or HT_EMPTY */
+static size_t _slot(const HT *ht, size_t i)
+{
+    switch (ht->width) {
+    case 1: {
+        uint8_t e = ((const uint8_t *)ht->index)[i];
+        return e == UINT8_MAX ? HT_EMPTY : e;
+    }
+    case 2: {
+        uint16_t e = ((const uint16_t *)ht->index)[i];
+        return e == UINT16_MAX ? HT_EMPTY : e;
+    }
+    default: {
+        uint32_t e = ((const uint32_t *)ht->index)[i];
+        return e == UINT32_MAX ? HT_EMPTY : e;
+    }
+    }
+}
+
+
+static void _set_slot(HT *ht, size_t i, size_t e)
+{
+    switch (ht->width) {
+    case 1:
+        ((uint8_t *)ht->index)[i] = (uint8_t)e;
+        break;
+    case 2:
+        ((uint16_t *)ht->index)[i] = (uint16_t)e;
+        break;
+    default:
+        ((uint32_t *)ht->index)[i] = (uint32_t)e;
+    }
+}
+
+
+/*
+probe for key: returns its entry number, or HT_EMPTY with *free_slot set to
+the empty slot it would go in
+*/
+static size_t _find(HT *ht, StrView key, uint64_t _hash, size_t *free_slot)
+{
+    // AND hash with capacity-1 to ensure it's within the index.
+    // this is essential same as hash % _total_size
+    size_t mask = ht->_total_size - 1;
+    size_t idx = (size_t)(_hash & (uint64_t)mask);
+
+    size_t e;
+    while ((e = _slot(ht, idx)) != HT_EMPTY) {
+        const char *curr = ht->items[e].key;
+
+        // keys are NUL terminated, the view is not: match the characters,
+        // then make sure the key ends where the view does
+        if (strncmp(curr, key.s, key.length) == 0 && curr[key.length] == '\0')
+            return e;
+
+        // probe till we find space, wrapping around
+        idx = (idx + 1) & mask;
+    }
+
+    if (free_slot)
+        *free_slot = idx;
+
+    return HT_EMPTY;
+}
+
+
+/* build a fresh index of new_size slots for the entries, which stay put */
+static void _reindex(HT *ht, size_t new_size)
+{
+    size_t width = _width(new_size);
+
+    void *index = mem_alloc(width * new_size);
+    if (!index)
+        mem_fail("Out of memory");
+
+    // all ones is empty, whatever the width
+    memset(index, 0xFF, width * new_size);
+
+    // mem_free(NULL) does nothing, as with the first index
+    mem_free(ht->index);
+
+    ht->index = index;
+    ht->width = width;
     ht->_total_size = new_size;
+
+    // keys are unique, so each entry just takes the first free slot
+    size_t mask = new_size - 1;
+    for (size_t e = 0; e < ht->length; e++) {
+        size_t idx = (size_t)(hash(ht, ht->items[e].key) & mask);
+
+        while (_slot(ht, idx) != HT_EMPTY)
+            idx = (idx + 1) & mask;
+
+        _set_slot(ht, idx, e);
+    }
+}
+
+
+static void _resize(HT *ht, size_t new_size)
+{
+    // the dense entries only ever need realloc'ing, then the index is
+    // rebuilt around them
+    Item *tmp = mem_realloc(ht->items, sizeof(*tmp) * _capacity(new_size));
+
+    if (!tmp)
+        mem_fail("Out of memory");
+
+    ht->items = tmp;
+    _reindex(ht, new_size);
+}
+
+
+/* smallest table that holds count entries below the 0.75 load factor */
+static size_t _fit(size_t count)
+{
+    size_t size = HT_MIN_SIZE;
+
+    while (_capacity(size) < count)
+        size *= 2;
+
+    return size;
 }
 
 
 static void resize(HT *ht)
 {
-    if (ht->length / (double)ht->_total_size >= 0.75) {
-        // double table size
-        _resize(ht, ht->_total_size * 2);
-    }
+    // full once the entries use up 3/4 of the slots
+    if (ht->length >= _capacity(ht->_total_size))
+        _resize(ht, ht->_total_size * ht->growth);
 }
 
 
-HT * create(void)
+void hash_growth(HT *ht, size_t factor)
+{
+    // the size has to stay a power of two, see the masking in _find
+    size_t growth = 2;
+    while (growth < factor)
+        growth *= 2;
+
+    ht->growth = growth;
+}
+
+
+void hash_shrink(HT *ht)
+{
+    size_t new_size = _fit(ht->length);
+
+    if (new_size < ht->_total_size)
+        _resize(ht, new_size);
+}
+
+
+static HT * _create(size_t size)
 {
     // alloc hash table
-    HT *hash_table = malloc(sizeof(*hash_table));
+    HT *hash_table = mem_alloc(sizeof(*hash_table));
     if (!hash_table) {
-        myprint("create", "hash_table", "-------- OUT OF MEMORY ---------");
+        myprint("create", "hash_table", OOM);
         goto error;
     }
 
     hash_table->length = 0;
-    hash_table->_total_size = HT_INIT_SIZE;
+    hash_table->growth = HT_GROWTH;
+    hash_table->hash_fn = HT_HASH;
+    hash_table->seed = 0;
+    hash_table->index = NULL;
 
     // create initial block of memory
-    Item *container = calloc(sizeof(*container), hash_table->_total_size);
+    Item *container = mem_alloc(sizeof(*container) * _capacity(size));
     if (!container)
-        goto container_calloc_error;
+        goto container_error;
 
     hash_table->items = container;
 
+    // with no entries this just sets up an empty index
+    _reindex(hash_table, size);
+
     return hash_table;
 
-container_calloc_error:
+container_error:
     // free hash_table to have no dangling pointer
-    free(hash_table);
-    myprint("create", "container", "-------- OUT OF MEMORY ---------");
+    mem_free(hash_table);
+    myprint("create", "container", OOM);
 
 
 error:
@@ -162,72 +419,86 @@ error:
 }
 
 
-void * get(HT *ht, const char *key)
+HT * create(void)
 {
-    uint64_t _hash = hash(key);
-    // AND hash with capacity-1 to ensure it's within entries array.
-    // this is essential same as hash % _total_size
-    size_t idx = (size_t)(_hash & (uint64_t)(ht->_total_size - 1));
-
-    void *result = NULL;
-    while (ht->items[idx].key != NULL) {
-        if (issame(ht->items[idx].key, key)) {
-            // we have found the key
-            result = ht->items[idx].value;
-            break;
-        }
+    return _create(HT_INIT_SIZE);
+}
 
-        // probe till we find space
-        idx++;
-        if (idx >= ht->_total_size)
-            // wrap around
-            idx = 0;
-    }
 
-    return result;
+HT * create_sized(size_t count)
+{
+    return _create(_fit(count));
 }
 
 
-char * _set(Item *items, size_t total_size, char *key, void *value, size_t *len)
+void destroy(HT *hash)
 {
-    uint64_t _hash = hash(key);
-    // AND hash with capacity-1 to ensure it's within entries array.
-    // this is essential same as hash % _total_size
-    size_t idx = (size_t)(_hash & (uint64_t)(total_size - 1));
-
-    char *result = NULL;
-    // add value to table, probe if needed
-    while (items[idx].key != NULL) {
-        // if key already exists, update value
-        if (issame(items[idx].key, key)) {
-            items[idx].value = value;
-            result = items[idx].key;
-            break;
-        }
+    if (!hash)
+        return;
 
-        // probe
-        idx++;
-        if (idx >= total_size)
-            // wrap around
-            idx = 0;
+    // keys and values belong to the table
+    for (size_t e = 0; e < hash->length; e++) {
+        mem_free(hash->items[e].key);
+        mem_free(hash->items[e].value);
     }
 
-    // if the key doesn't exist, set it here
-    if (result == NULL) {
-        // copy key
-        result = strdup(key);
-        if (!result)
-            return NULL;
+    mem_free(hash->items);
+    mem_free(hash->index);
+    mem_free(hash);
+}
 
-        if (len != NULL)
-            // increment length
-            (*len)++;
 
-        items[idx].key = (char *)result;
-        items[idx].value = value;
+void hash_function(HT *ht, HashFunc fn, uint64_t seed)
+{
+    ht->hash_fn = fn;
+    ht->seed = seed;
+
+    // slots depend on the hash, the entries themselves don't move
+    if (ht->length)
+        _reindex(ht, ht->_total_size);
+}
+
+
+ProbeStats hash_probe_stats(HT *ht)
+{
+    ProbeStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    size_t mask = ht->_total_size - 1;
+
+    for (size_t i = 0; i < ht->_total_size; i++) {
+        size_t e = _slot(ht, i);
+        if (e == HT_EMPTY)
+            continue;
+
+        // distance from the slot the key hashes to, wrapping around
+        size_t home = (size_t)(hash(ht, ht->items[e].key) & mask);
+        size_t probes = ((i - home) & mask) + 1;
+
+        stats.entries++;
+        stats.total += probes;
+
+        if (probes > stats.max)
+            stats.max = probes;
+
+        stats.histogram[(probes < PROBE_BUCKETS ? probes : PROBE_BUCKETS) - 1]++;
     }
 
-    return result;
+    return stats;
+}
+
+
+void * get(HT *ht, const char *key)
+{
+    return get_view(ht, view(key));
+}
+
+
+void * get_view(HT *ht, StrView key)
+{
+    size_t e = _find(ht, key, ht->hash_fn(key, ht->seed), NULL);
+
+    return e == HT_EMPTY ? NULL : ht->items[e].value;
 }
 
 
@@ -236,15 +507,37 @@ const char * set(HT *ht, char *key, void *value)
     if (value == NULL)
         return NULL;
 
-    // resize, if needed
-    resize(ht);
+    size_t idx;
+    uint64_t h = hash(ht, key);
+    size_t e = _find(ht, view(key), h, &idx);
 
-    // const char *result = _set(ht->items, ht->_total_size, key, value, &ht->length);
+    // if key already exists, update value; the old one is the table's
+    // to free, like destroy() would
+    if (e != HT_EMPTY) {
+        if (ht->items[e].value != value)
+            mem_free(ht->items[e].value);
 
-    // if (result)
-    //     ht->length++;
+        ht->items[e].value = value;
+        return ht->items[e].key;
+    }
 
-    return _set(ht->items, ht->_total_size, key, value, &ht->length);
+    // only a new key can need more room; resizing moves the free slot
+    if (ht->length >= _capacity(ht->_total_size)) {
+        resize(ht);
+        _find(ht, view(key), h, &idx);
+    }
+
+    char *copy = copy_key(key);
+    if (!copy)
+        return NULL;
+
+    // new entries go on the end, and the free slot points at them
+    e = ht->length++;
+    ht->items[e].key = copy;
+    ht->items[e].value = value;
+    _set_slot(ht, idx, e);
+
+    return copy;
 }
 
 
@@ -269,21 +562,226 @@ bool next(HTI *iter)
 {
     HT *table = iter->_table;
 
-    bool result = false;
-    while (iter->idx < table->_total_size) {
-        size_t idx = iter->idx;
-        iter->idx++;
+    // entries are dense, so this is a plain walk in insertion order
+    if (iter->idx >= table->length)
+        return false;
 
-        Item curr = table->items[idx];
-        if (curr.key) {
-            // found a non-empty slot in table
-            iter->key = curr.key;
-            iter->value = curr.value;
+    Item curr = table->items[iter->idx++];
+    iter->key = curr.key;
+    iter->value = curr.value;
 
-            result = true;
-            break;
-        }
+    return true;
+}
+
+
+const StaticItem * get_static(const StaticHT *table, StrView key)
+{
+    const StaticItem *item = &table->slots[hash_wy(key, table->seed) & table->mask];
+
+    // perfect hash: the key is in this slot or not in the table at all
+    if (
+        item->key == NULL ||
+        strncmp(item->key, key.s, key.length) != 0 ||
+        item->key[key.length] != '\0'
+    )
+        return NULL;
+
+    return item;
+}
+
+
+// ------------------- export -------------------
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t strings_size;
+} FileHeader;
+
+
+typedef struct {
+    uint32_t key;    // offsets into the string table
+    uint32_t value;
+} FileRecord;
+
+
+struct HTFile {
+    const FileRecord *records;
+    size_t length;
+    const char *strings;
+
+    void *mapping;
+    size_t mapping_size;
+};
+
+
+static int _by_key(const void *a, const void *b)
+{
+    return strcmp(((const Item *)a)->key, ((const Item *)b)->key);
+}
+
+
+int hash_export(HT *ht, const char *path)
+{
+    int ok = 0;
+    size_t n = ht->length;
+
+    Item *sorted = mem_alloc(sizeof(*sorted) * (n ? n : 1));
+    FileRecord *records = mem_alloc(sizeof(*records) * (n ? n : 1));
+    FILE *fp = fopen(path, "wb");
+
+    if (!sorted || !records || !fp)
+        goto cleanup;
+
+    memcpy(sorted, ht->items, sizeof(*sorted) * n);
+    qsort(sorted, n, sizeof(*sorted), _by_key);
+
+    // strings go in sorted order too: key, value, key, value, ...
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++) {
+        records[i].key = (uint32_t)offset;
+        offset += strlen(sorted[i].key) + 1;
+
+        records[i].value = (uint32_t)offset;
+        offset += strlen((char *)sorted[i].value) + 1;
+    }
+
+    FileHeader header;
+    memcpy(header.magic, HT_FILE_MAGIC, sizeof(header.magic));
+    header.version = HT_FILE_VERSION;
+    header.count = (uint32_t)n;
+    header.strings_size = (uint32_t)offset;
+
+    ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+    if (ok && n)
+        ok = fwrite(records, sizeof(*records), n, fp) == n;
+
+    for (size_t i = 0; ok && i < n; i++) {
+        const char *key = sorted[i].key;
+        const char *value = sorted[i].value;
+
+        ok = fwrite(key, 1, strlen(key) + 1, fp) == strlen(key) + 1 &&
+            fwrite(value, 1, strlen(value) + 1, fp) == strlen(value) + 1;
+    }
+
+cleanup:
+    if (fp && fclose(fp) != 0)
+        ok = 0;
+
+    mem_free(sorted);
+    mem_free(records);
+
+    return ok ? 0 : -1;
+}
+
+
+HTFile * hash_file_open(const char *path)
+{
+    void *mapping = MAP_FAILED;
+    struct stat st;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader))
+        goto error;
+
+    mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+        goto error;
+
+    const FileHeader *header = mapping;
+    const FileRecord *records = (const FileRecord *)(header + 1);
+    const char *strings = (const char *)(records + header->count);
+    size_t expected = sizeof(*header)
+        + (size_t)header->count * sizeof(*records)
+        + header->strings_size;
+
+    if (
+        memcmp(header->magic, HT_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != HT_FILE_VERSION ||
+        expected != (size_t)st.st_size ||
+        // every string, including the last, must be NUL terminated
+        (header->strings_size && strings[header->strings_size - 1] != '\0')
+    )
+        goto error;
+
+    for (size_t i = 0; i < header->count; i++) {
+        if (records[i].key >= header->strings_size || records[i].value >= header->strings_size)
+            goto error;
+    }
+
+    HTFile *file = mem_alloc(sizeof(*file));
+    if (!file)
+        goto error;
+
+    file->records = records;
+    file->length = header->count;
+    file->strings = strings;
+    file->mapping = mapping;
+    file->mapping_size = (size_t)st.st_size;
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    return file;
+
+error:
+    if (mapping != MAP_FAILED)
+        munmap(mapping, (size_t)st.st_size);
+    close(fd);
+    return NULL;
+}
+
+
+size_t hash_file_length(HTFile *file)
+{
+    return file->length;
+}
+
+
+const char * hash_file_key(HTFile *file, size_t i)
+{
+    return i < file->length ? file->strings + file->records[i].key : NULL;
+}
+
+
+const char * hash_file_value(HTFile *file, size_t i)
+{
+    return i < file->length ? file->strings + file->records[i].value : NULL;
+}
+
+
+const char * hash_file_get(HTFile *file, const char *key)
+{
+    // records are sorted by key
+    size_t lo = 0;
+    size_t hi = file->length;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(key, file->strings + file->records[mid].key);
+
+        if (cmp == 0)
+            return file->strings + file->records[mid].value;
+
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
     }
 
-    return result;
+    return NULL;
+}
+
+
+void hash_file_close(HTFile *file)
+{
+    if (!file)
+        return;
+
+    munmap(file->mapping, file->mapping_size);
+    mem_free(file);
 }
@@ -4,32 +4,125 @@
 #define HASH
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "alloc.h"
+#include "strview.h"
+
 
 typedef struct HT HT;
 
+/*
+Hash function used for a table's keys. Slots are picked with the low bits
+(hash & (size - 1)), so those need to depend on every byte of the key.
+*/
+typedef uint64_t (*HashFunc)(StrView key, uint64_t seed);
+
+/* byte at a time FNV-1a, the seed is folded into the offset basis */
+uint64_t hash_fnv1a(StrView, uint64_t seed);
+/*
+wyhash style: reads the key 4 or 8 bytes at a time and mixes with 128 bit
+multiplies. With a seed from hash_random_seed() the slots a key lands in
+cannot be predicted, so crafted keys cannot force long probe chains.
+*/
+uint64_t hash_wy(StrView, uint64_t seed);
+uint64_t hash_random_seed(void);
+
+// probe lengths 1 .. PROBE_BUCKETS - 1, the last bucket counts the rest
+#define PROBE_BUCKETS 8
+
+typedef struct {
+    size_t entries;
+    size_t total;     // sum of probe lengths, a key in its home slot is 1
+    size_t max;
+    size_t histogram[PROBE_BUCKETS];
+} ProbeStats;
+
 typedef struct {
     char *key;     // entry key, used for lockup
     void *value;   // value associated with key
 
     HT * _table;   // reference to the hash table
-    size_t idx;    // current index into ht._entries
+    size_t idx;    // current index into the table's entries
 } HTI;
 
 
 HT * create(void);
+/* table with room for count entries, so count sets never resize */
+HT * create_sized(size_t count);
 void * get(HT *, const char *);
+/* get without a NUL terminated copy of the key, e.g. a slice of a line */
+void * get_view(HT *, StrView);
+/*
+key is copied, value is taken over: destroy() hands it to mem_free(), and
+so does setting the key again, which frees the value it replaces. Values
+must come from mem_alloc() (dupstr() does) unless the table is never
+destroyed and no key is set twice. Returns the table's copy of the key.
+*/
 const char * set(HT *, char *, void *);
 size_t length(HT *);
 
 HTI iterator(HT *);
 // Move iterator to next item in hash table, update iterator's key
 // and value to current item, and return true. If there are no more
-// items, return false. Don't call ht_set during iteration.
+// items, return false. Items come in the order they were first set.
+// Keys set during iteration are visited too.
 bool next(HTI *);
 
+// frees the table, its keys and its values
 void destroy(HT *);
 
+// factor the table grows by, rounded up to a power of two (default 2)
+void hash_growth(HT *, size_t factor);
+// rehash into the smallest table that fits the current entries
+void hash_shrink(HT *);
+
+// switch hash function (and seed), rehashing any entries
+void hash_function(HT *, HashFunc, uint64_t seed);
+// how far entries are from their home slot
+ProbeStats hash_probe_stats(HT *);
+
+/*
+Write the table to path sorted by key, for other tools to mmap and search
+with hash_file_open(). Values must be NUL terminated strings, as they are in
+the assembler's tables. The file is a header (magic "HTEX", version, count,
+size of the string table), count {uint32 key, uint32 value} offsets into the
+string table in key order, then the strings. Returns 0 on success.
+*/
+int hash_export(HT *, const char *path);
+
+typedef struct HTFile HTFile;
+
+HTFile * hash_file_open(const char *path);    // NULL if missing or invalid
+size_t hash_file_length(HTFile *);
+const char * hash_file_key(HTFile *, size_t);    // i-th key in sorted order
+const char * hash_file_value(HTFile *, size_t);
+const char * hash_file_get(HTFile *, const char *key);  // binary search, NULL if absent
+void hash_file_close(HTFile *);
+
+/*
+Read-only table baked into the binary by a generator (see gen_tables.c), for
+tables whose contents are known at build time. Slots are picked with
+hash_wy(key, seed) & mask, and the generator searched for a seed that puts
+every key in a slot of its own, so a lookup is one hash and one compare:
+no allocation, no probing, nothing to set up at startup. The values are the
+numbers the assembler wants, instruction field bits or addresses, so there
+is nothing to parse after the lookup either.
+*/
+typedef struct {
+    const char *key;     // NULL for an empty slot
+    uint16_t value;
+} StaticItem;
+
+typedef struct {
+    const StaticItem *slots;
+    size_t mask;         // slot count - 1
+    uint64_t seed;
+} StaticHT;
+
+// the item for key, NULL if it isn't in the table
+const StaticItem * get_static(const StaticHT *, StrView key);
+
 #endif
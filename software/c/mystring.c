@@ -1,13 +1,12 @@
 /* An attempt at as C string library */
 
 #include <stdio.h>
+#include <string.h>
 
+#include "alloc.h"
 #include "mystring.h"
 
 
-#define OOM "-------- OUT OF MEMORY ---------"
-
-
 /* exit with an error message */
 static void exit_with_message(char *func_name, char *ptr_name, char *message)
 {
@@ -16,68 +15,93 @@ static void exit_with_message(char *func_name, char *ptr_name, char *message)
 }
 
 
-void freestr(String w)
+/*
+set up str to hold length characters and return where to write them. Short
+strings point into str itself, so the result is only good for that String.
+*/
+static char * reserve(String *str, size_t length)
 {
-    if (!w.s)
-        return;
+    str->length = length;
+
+    if (length <= STR_INLINE_MAX)
+        return str->_data.local;
+
+    // using *buff in the sizeof function 'locks' together the declaration and
+    // type information i.e. if buff type changes, the malloc does not need to
+    // change as well. This gives less room for errors.
+    // more info: https://stackoverflow.com/a/605858
+    char *buff = mem_alloc(sizeof(*buff) * (length + 1));
 
-    free(w.s);
+    if (!buff)
+        mem_fail("Out of memory");
 
-    if (w.s != NULL)
-        w.s = NULL;
+    str->_data.heap = buff;
+    return buff;
 }
 
 
-String concat(const String w1, const String w2)
+char * cstr(const String *str)
 {
-    String newString;
+    // like strchr, hand back a mutable pointer so callers filling in a
+    // String they own need no cast
+    return str->length <= STR_INLINE_MAX ? (char *)str->_data.local : str->_data.heap;
+}
 
-    char *buff = malloc(sizeof(*buff) * (w1.length + w2.length + 1));
 
-    if (!buff)
-        // 'catch' oom error
-        goto oom_error;
+char * dupstr(const String str)
+{
+    char *result = mem_alloc(sizeof(*result) * (str.length + 1));
 
-    size_t i = 0;
-    size_t j = 0;
+    if (!result)
+        mem_fail("Out of memory");
 
-    while (i < w1.length) {
-        buff[i] = w1.s[i];
-        i++;
-    }
+    return memcpy(result, cstr(&str), str.length + 1);
+}
 
-    while (j < w2.length) {
-        buff[i++] = w2.s[j++];
-    }
 
-    // set final character
-    buff[i] = '\0';
+void freestr(String w)
+{
+    if (w.length <= STR_INLINE_MAX)
+        return;
+
+    mem_free(w._data.heap);
+}
+
+
+String concat(const String w1, const String w2)
+{
+    String newString;
+
+    char *buff = reserve(&newString, w1.length + w2.length);
 
-    newString.s = buff;
-    newString.length = w1.length + w2.length;
+    memcpy(buff, cstr(&w1), w1.length);
+    memcpy(buff + w1.length, cstr(&w2), w2.length);
+
+    // set final character
+    buff[newString.length] = '\0';
 
     // free strings in w1, w2
     freestr(w1);
     freestr(w2);
 
     return newString;
-
-oom_error:
-    // free strings before exiting
-    freestr(w1);
-    freestr(w2);
-    exit_with_message("concat", "buff", OOM);
-    // return empty string for the compiler, does not matter as we will exit
-    // anyways
-    return (String){0, NULL};
 }
 
 
-String concatRaw(const String w1, char w2[])
+String concatRaw(const String w1, const char w2[])
 {
-    // turn w2 to a proper string, then concatenate
-    String n = newstr(w2);
-    return concat(w1, n);
+    // copy w2 straight in rather than making a String of it first
+    size_t len = strlen(w2);
+    String n;
+
+    char *buff = reserve(&n, w1.length + len);
+
+    memcpy(buff, cstr(&w1), w1.length);
+    memcpy(buff + w1.length, w2, len + 1);
+
+    freestr(w1);
+
+    return n;
 }
 
 
@@ -85,61 +109,31 @@ String concatChar(const String w1, char w2[])
 {
     String n;
 
-    char *buff = calloc(sizeof(*buff), (w1.length + 2));
-    if (!buff)
-        // 'catch' oom error
-        goto oom_error;
+    char *buff = reserve(&n, w1.length + 1);
 
-    for (size_t i = 0; i < w1.length; i++)
-        buff[i] = w1.s[i];
+    memcpy(buff, cstr(&w1), w1.length);
 
-    // string is 0 indexed so buff[w1.length] is one past the last buff element
+    // string is 0 indexed so buff[w1.length] is one past the last w1 char
     buff[w1.length] = w2[0];
     buff[w1.length + 1] = '\0';
 
-    n.s = buff;
-    n.length = w1.length + 1;
-
     freestr(w1);
 
     return n;
-
-oom_error:
-    // free w1 before exiting
-    freestr(w1);
-    exit_with_message("concatChar", "buff", OOM);
-    // return empty string for the compiler, does not matter as we will exit anyways
-    return (String){0, NULL};
 }
 
 
 int startswith(const String haystack, char n[])
 {
-    // we create the needle string in here so we can free it after the
-    // comparison
-    String needle = newstr(n);
-
-    int result = 0;
-
-    if (needle.length <= haystack.length) {
-        // we need to create this tmp variable as we'll be moving through the
-        // string using pointers and in order to successfully free the string the
-        // pointer variable needs to point to the beginning, otherwise it
-        // causes a memory free error.
-        char *tmp = needle.s;
-        for (size_t i = 0; i < needle.length; i++, tmp++) {
-            if (*tmp != haystack.s[i])
-                break;
-        }
-
-        // if we got to the end of the needle, result == 1, else 0
-        result = (*tmp == '\0');
-    }
-
-    // free the string contents of the needle
-    freestr(needle);
-
-    return result;
+    const char *hs = cstr(&haystack);
+
+    // walk the needle in place, the haystack's '\0' stops a longer needle
+    size_t i = 0;
+    while (n[i] != '\0' && n[i] == hs[i])
+        i++;
+
+    // if we got to the end of the needle, result == 1, else 0
+    return n[i] == '\0';
 }
 
 
@@ -149,7 +143,7 @@ char charat(const String str, size_t index)
     if (index >= str.length)
         exit_with_message("charat", "None", "Out of bounds error");
 
-    char val = str.s[index];
+    char val = cstr(&str)[index];
     return val;
 }
 
@@ -158,27 +152,11 @@ String newstr(char word[])
 {
     String newString;
 
-    size_t length = 0;
-    while (word[length] != '\0')
-        length++;
-
-    // using *buff in the sizeof function 'locks' together the declaration and
-    // type information i.e. if buff type changes, the malloc does not need to
-    // change as well. This gives less room for errors.
-    // more info: https://stackoverflow.com/a/605858
-    char *buff = malloc(sizeof(*buff) * length + 1);
-
-    if (!buff)
-        exit_with_message("newstr", "buff", OOM);
-
-    size_t i = 0;
-    // copy word to buffer
-    while ((buff[i] = *word++) != '\0')
-        i++;
+    size_t length = strlen(word);
+    char *buff = reserve(&newString, length);
 
-    buff[i] = '\0';
-    newString.s = buff;
-    newString.length = length;
+    // copy word to buffer, including the '\0'
+    memcpy(buff, word, length + 1);
 
     return newString;
 }
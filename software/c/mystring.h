@@ -6,16 +6,38 @@
 #include <stdlib.h>
 
 
-/* simple struct for managing strings */
+/* strings up to this many characters are stored inline, without a malloc */
+#define STR_INLINE_MAX 22
+
+/*
+simple struct for managing strings
+
+Short strings (most assembler tokens: "D", "M", "0", "JMP", labels) live in
+the struct itself, longer ones on the heap. Either way the characters are
+NUL terminated; use cstr() to get at them rather than the union directly.
+*/
 typedef struct {
     size_t length;
-    char *s;
+    union {
+        char *heap;                      // length > STR_INLINE_MAX
+        char local[STR_INLINE_MAX + 1];  // length <= STR_INLINE_MAX
+    } _data;
 } String;
 
 
 /* create new string */
 String newstr(char *);
 
+/*
+pointer to the NUL terminated characters of the string. This takes a pointer
+because short strings are stored inside the String itself: the result is
+only valid for as long as *str is, and not for a copy of it.
+*/
+char * cstr(const String *);
+
+/* mem_alloc'ed copy of the characters, for keeping them beyond the String */
+char * dupstr(const String);
+
 /* get char at the given index - if out of bounds, log error and exit */
 char charat(const String, size_t idx);
 
@@ -23,7 +45,7 @@ char charat(const String, size_t idx);
 String concat(const String, const String);
 
 /* concatenate a string with a character array (i.e. c string) */
-String concatRaw(const String, char *);
+String concatRaw(const String, const char *);
 
 /*
 concatenate a single character with pre-existing string. This is useful
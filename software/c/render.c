@@ -0,0 +1,34 @@
+/* .hack rendering implementation. */
+
+#include <string.h>
+
+#include "render.h"
+
+
+// the 8 characters of byte n, most significant bit first
+#define BIT(n, i) (char)('0' + (((n) >> (i)) & 1))
+#define BYTE(n) {BIT(n, 7), BIT(n, 6), BIT(n, 5), BIT(n, 4), BIT(n, 3), BIT(n, 2), BIT(n, 1), BIT(n, 0)}
+
+#define BYTES_4(n) BYTE(n), BYTE(n + 1), BYTE(n + 2), BYTE(n + 3)
+#define BYTES_16(n) BYTES_4(n), BYTES_4(n + 4), BYTES_4(n + 8), BYTES_4(n + 12)
+#define BYTES_64(n) BYTES_16(n), BYTES_16(n + 16), BYTES_16(n + 32), BYTES_16(n + 48)
+
+// not strings, there is no room for a NUL
+static const char BITS[256][8] = {
+    BYTES_64(0), BYTES_64(64), BYTES_64(128), BYTES_64(192),
+};
+
+
+size_t render_words(const uint16_t *words, size_t count, char *out)
+{
+    for (size_t i = 0; i < count; i++) {
+        // fixed size copies, the compiler makes each a single 8 byte move
+        memcpy(out, BITS[words[i] >> 8], 8);
+        memcpy(out + 8, BITS[words[i] & 0xFF], 8);
+        out[16] = '\n';
+
+        out += RENDER_LINE;
+    }
+
+    return count * RENDER_LINE;
+}
@@ -0,0 +1,24 @@
+/* Hack words -> the text of a .hack file */
+
+#ifndef RENDER
+#define RENDER
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// bytes a word takes in a .hack file: 16 '0'/'1' characters and a '\n'
+#define RENDER_LINE 17
+
+/*
+Write count words to out as .hack lines, most significant bit first. out
+needs room for count * RENDER_LINE bytes, nothing is NUL terminated.
+Returns the number of bytes written.
+
+Each byte of a word is one lookup in a 256 entry table of its 8 characters,
+so a word is two 8 byte copies and a '\n', with no formatting or
+allocation.
+*/
+size_t render_words(const uint16_t *words, size_t count, char *out);
+
+#endif
@@ -0,0 +1,301 @@
+/* Source map implementation. */
+
+// mmap and friends are POSIX, not C99
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "srcmap.h"
+
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t strings_size;
+} Header;
+
+
+struct SrcMap {
+    // building: entries and strings are malloc'ed and grow as needed
+    // reading: both point into the mapping
+    SrcEntry *entries;
+    size_t length;
+    size_t _total_size;
+
+    char *strings;
+    size_t strings_size;
+    size_t _strings_total;
+
+    // origin given to the next word
+    uint32_t origin_file;
+    uint32_t origin_line;
+
+    // NULL unless the map came from srcmap_open
+    void *mapping;
+    size_t mapping_size;
+};
+
+
+#define SRCMAP_MAGIC "HSMP"
+#define SRCMAP_INIT_SIZE 256
+#define OOM "-------- OUT OF MEMORY ---------"
+
+
+static void myprint(char *func_name, char *ptr_name, char *message)
+{
+    printf("(%s)-(%s): %s", func_name, ptr_name, message);
+}
+
+
+SrcMap * srcmap_new(void)
+{
+    SrcMap *map = mem_calloc(sizeof(*map), 1);
+    if (!map)
+        goto error;
+
+    map->entries = mem_alloc(sizeof(*map->entries) * SRCMAP_INIT_SIZE);
+    if (!map->entries)
+        goto error;
+
+    map->_total_size = SRCMAP_INIT_SIZE;
+    map->origin_file = SRCMAP_NONE;
+
+    return map;
+
+error:
+    myprint("srcmap_new", "map", OOM);
+    if (map)
+        mem_free(map);
+    return NULL;
+}
+
+
+/* offset of name in the file name table, adding it if it is not there yet */
+static uint32_t intern(SrcMap *map, const char *name, size_t len)
+{
+    // a program has one file per class, so a scan is cheap enough
+    size_t offset = 0;
+    while (offset < map->strings_size) {
+        const char *curr = map->strings + offset;
+        size_t curr_len = strlen(curr);
+
+        if (curr_len == len && memcmp(curr, name, len) == 0)
+            return (uint32_t)offset;
+
+        offset += curr_len + 1;
+    }
+
+    if (map->strings_size + len + 1 > map->_strings_total) {
+        size_t new_size = map->_strings_total ? map->_strings_total * 2 : SRCMAP_INIT_SIZE;
+        while (new_size < map->strings_size + len + 1)
+            new_size *= 2;
+
+        char *tmp = mem_realloc(map->strings, new_size);
+        if (!tmp) {
+            myprint("intern", "strings", OOM);
+            return SRCMAP_NONE;
+        }
+
+        map->strings = tmp;
+        map->_strings_total = new_size;
+    }
+
+    offset = map->strings_size;
+    memcpy(map->strings + offset, name, len);
+    map->strings[offset + len] = '\0';
+    map->strings_size += len + 1;
+
+    return (uint32_t)offset;
+}
+
+
+int srcmap_directive(SrcMap *map, const char *line)
+{
+    while (*line == ' ' || *line == '\t')
+        line++;
+
+    size_t prefix = strlen(SRCMAP_DIRECTIVE);
+    if (strncmp(line, SRCMAP_DIRECTIVE, prefix) != 0)
+        return 0;
+
+    line += prefix;
+
+    // the line number follows the last ':', so file names may contain one
+    const char *colon = strrchr(line, ':');
+    if (!colon || colon == line)
+        return 0;
+
+    char *end;
+    unsigned long origin_line = strtoul(colon + 1, &end, 10);
+    if (end == colon + 1)
+        return 0;
+
+    map->origin_file = intern(map, line, (size_t)(colon - line));
+    map->origin_line = (uint32_t)origin_line;
+
+    return 1;
+}
+
+
+int srcmap_add(SrcMap *map, uint32_t asm_line)
+{
+    if (map->length == map->_total_size) {
+        size_t new_size = map->_total_size * 2;
+
+        SrcEntry *tmp = mem_realloc(map->entries, sizeof(*tmp) * new_size);
+        if (!tmp) {
+            myprint("srcmap_add", "entries", OOM);
+            return -1;
+        }
+
+        map->entries = tmp;
+        map->_total_size = new_size;
+    }
+
+    SrcEntry *entry = &map->entries[map->length++];
+    entry->asm_line = asm_line;
+    entry->origin_file = map->origin_file;
+    entry->origin_line = map->origin_file == SRCMAP_NONE ? 0 : map->origin_line;
+
+    return 0;
+}
+
+
+int srcmap_write(SrcMap *map, const char *path)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+        return -1;
+
+    int ok = srcmap_write_file(map, fp) == 0;
+
+    if (fclose(fp) != 0)
+        ok = 0;
+
+    return ok ? 0 : -1;
+}
+
+
+int srcmap_write_file(SrcMap *map, FILE *fp)
+{
+    Header header;
+    memcpy(header.magic, SRCMAP_MAGIC, sizeof(header.magic));
+    header.version = SRCMAP_VERSION;
+    header.count = (uint32_t)map->length;
+    header.strings_size = (uint32_t)map->strings_size;
+
+    int ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+    if (ok && map->length)
+        ok = fwrite(map->entries, sizeof(*map->entries), map->length, fp) == map->length;
+
+    if (ok && map->strings_size)
+        ok = fwrite(map->strings, 1, map->strings_size, fp) == map->strings_size;
+
+    return ok ? 0 : -1;
+}
+
+
+SrcMap * srcmap_open(const char *path)
+{
+    SrcMap *map = NULL;
+    void *mapping = MAP_FAILED;
+    struct stat st;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header))
+        goto error;
+
+    mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+        goto error;
+
+    const Header *header = mapping;
+    size_t expected = sizeof(Header)
+        + (size_t)header->count * sizeof(SrcEntry)
+        + header->strings_size;
+
+    if (
+        memcmp(header->magic, SRCMAP_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SRCMAP_VERSION ||
+        expected != (size_t)st.st_size ||
+        // every name, including the last, must be NUL terminated
+        (header->strings_size && ((char *)mapping)[expected - 1] != '\0')
+    )
+        goto error;
+
+    map = mem_calloc(sizeof(*map), 1);
+    if (!map)
+        goto error;
+
+    // entries start right after the 16 byte header so they stay aligned
+    map->entries = (SrcEntry *)((char *)mapping + sizeof(Header));
+    map->length = header->count;
+    map->strings = (char *)(map->entries + header->count);
+    map->strings_size = header->strings_size;
+    map->mapping = mapping;
+    map->mapping_size = (size_t)st.st_size;
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    return map;
+
+error:
+    if (mapping != MAP_FAILED)
+        munmap(mapping, (size_t)st.st_size);
+    close(fd);
+    return NULL;
+}
+
+
+size_t srcmap_length(SrcMap *map)
+{
+    return map->length;
+}
+
+
+const SrcEntry * srcmap_lookup(SrcMap *map, size_t address)
+{
+    if (address >= map->length)
+        return NULL;
+
+    return &map->entries[address];
+}
+
+
+const char * srcmap_file(SrcMap *map, const SrcEntry *entry)
+{
+    // an offset past the table means a corrupt file, treat it as no origin
+    if (entry->origin_file == SRCMAP_NONE || entry->origin_file >= map->strings_size)
+        return NULL;
+
+    return map->strings + entry->origin_file;
+}
+
+
+void srcmap_free(SrcMap *map)
+{
+    if (!map)
+        return;
+
+    if (map->mapping) {
+        munmap(map->mapping, map->mapping_size);
+    } else {
+        mem_free(map->entries);
+        mem_free(map->strings);
+    }
+
+    mem_free(map);
+}
@@ -0,0 +1,63 @@
+/* Source map: ROM address -> .asm line (and .vm/.jack origin) */
+
+#ifndef SRCMAP
+#define SRCMAP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+On disk the map is a fixed header, one fixed size entry per ROM word and a
+table of NUL terminated file names, all in host byte order:
+
+    char     magic[4]       "HSMP"
+    uint32_t version        SRCMAP_VERSION
+    uint32_t count          number of ROM words / entries
+    uint32_t strings_size   bytes in the file name table
+    SrcEntry entries[count]
+    char     strings[strings_size]
+
+Entry N describes ROM address N, so a lookup is a single index into the
+mmap'ed file.
+*/
+#define SRCMAP_VERSION 1
+
+// origin_file of a word that has no known origin
+#define SRCMAP_NONE 0xFFFFFFFFu
+
+/*
+Lines of the form `// @src <file>:<line>` in the .asm set the origin of the
+words that follow, until the next such line. A VM translator can emit one
+per VM command (`// @src Main.vm:12`) and pass along what the compiler gave
+it in the same way for .jack.
+*/
+#define SRCMAP_DIRECTIVE "// @src "
+
+typedef struct {
+    uint32_t asm_line;     // 1-based line in the .asm file
+    uint32_t origin_file;  // offset into the file name table or SRCMAP_NONE
+    uint32_t origin_line;  // line in origin_file, 0 when there is none
+} SrcEntry;
+
+typedef struct SrcMap SrcMap;
+
+// building a map while assembling
+SrcMap * srcmap_new(void);
+// returns 1 if the line was an origin directive, 0 otherwise
+int srcmap_directive(SrcMap *, const char *line);
+// next ROM word came from asm_line; 0 on success, -1 if out of memory, when
+// the word is missing and every address after it would be off by one
+int srcmap_add(SrcMap *, uint32_t asm_line);
+int srcmap_write(SrcMap *, const char *path);  // 0 on success, -1 on error
+int srcmap_write_file(SrcMap *, FILE *);       // the same, to an open stream
+
+// reading a written map, the file is mmap'ed rather than parsed
+SrcMap * srcmap_open(const char *path);       // NULL if missing or invalid
+size_t srcmap_length(SrcMap *);
+const SrcEntry * srcmap_lookup(SrcMap *, size_t address);  // NULL if out of range
+const char * srcmap_file(SrcMap *, const SrcEntry *);      // NULL if no origin
+
+void srcmap_free(SrcMap *);
+
+#endif
@@ -0,0 +1,157 @@
+/* String view implementation. */
+
+#include <string.h>
+
+#include "hash.h"
+#include "strview.h"
+
+
+StrView view(const char *s)
+{
+    StrView v = {s, strlen(s)};
+    return v;
+}
+
+
+StrView view_str(const String *str)
+{
+    StrView v = {cstr(str), str->length};
+    return v;
+}
+
+
+StrView subview(StrView v, size_t start, size_t length)
+{
+    if (start > v.length)
+        start = v.length;
+
+    if (length > v.length - start)
+        length = v.length - start;
+
+    StrView result = {v.s + start, length};
+    return result;
+}
+
+
+size_t view_find(StrView v, char c)
+{
+    const char *found = v.length ? memchr(v.s, c, v.length) : NULL;
+
+    return found ? (size_t)(found - v.s) : VIEW_NPOS;
+}
+
+
+size_t view_find_str(StrView v, StrView needle)
+{
+    if (needle.length == 0)
+        return 0;
+
+    if (needle.length > v.length)
+        return VIEW_NPOS;
+
+    size_t i = 0;
+    while (needle.length <= v.length - i) {
+        // jump straight to the next place the first character matches
+        size_t next = view_find(subview(v, i, VIEW_NPOS), needle.s[0]);
+        if (next == VIEW_NPOS)
+            break;
+
+        i += next;
+        if (needle.length > v.length - i)
+            break;
+
+        if (memcmp(v.s + i, needle.s, needle.length) == 0)
+            return i;
+
+        i++;
+    }
+
+    return VIEW_NPOS;
+}
+
+
+static bool isspace_(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+
+StrView view_trim(StrView v)
+{
+    while (v.length && isspace_(v.s[0])) {
+        v.s++;
+        v.length--;
+    }
+
+    while (v.length && isspace_(v.s[v.length - 1]))
+        v.length--;
+
+    return v;
+}
+
+
+int view_cmp(StrView a, StrView b)
+{
+    size_t n = a.length < b.length ? a.length : b.length;
+
+    int result = n ? memcmp(a.s, b.s, n) : 0;
+    if (result != 0)
+        return result;
+
+    // equal up to the shorter one, so the shorter one sorts first
+    return (a.length > b.length) - (a.length < b.length);
+}
+
+
+bool view_eq(StrView a, StrView b)
+{
+    return a.length == b.length && (a.length == 0 || memcmp(a.s, b.s, a.length) == 0);
+}
+
+
+bool view_prefix(StrView v, StrView prefix)
+{
+    return prefix.length <= v.length && view_eq(subview(v, 0, prefix.length), prefix);
+}
+
+
+bool view_suffix(StrView v, StrView suffix)
+{
+    return suffix.length <= v.length &&
+        view_eq(subview(v, v.length - suffix.length, suffix.length), suffix);
+}
+
+
+uint64_t view_hash(StrView v)
+{
+    return hash_fnv1a(v, 0);
+}
+
+
+SplitIter view_split(StrView v, char sep)
+{
+    SplitIter it = {v, sep};
+    return it;
+}
+
+
+bool split_next(SplitIter *it, StrView *part)
+{
+    // skip separators, empty pieces are not returned
+    while (it->rest.length && it->rest.s[0] == it->sep) {
+        it->rest.s++;
+        it->rest.length--;
+    }
+
+    if (it->rest.length == 0)
+        return false;
+
+    size_t end = view_find(it->rest, it->sep);
+    if (end == VIEW_NPOS)
+        end = it->rest.length;
+
+    *part = subview(it->rest, 0, end);
+    it->rest = subview(it->rest, end, it->rest.length - end);
+
+    return true;
+}
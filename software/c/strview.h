@@ -0,0 +1,66 @@
+/* Non-owning string views */
+
+#ifndef STRVIEW
+#define STRVIEW
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mystring.h"
+
+
+/*
+A pointer and a length into characters owned by someone else: a C string, a
+String or a line of the input. Views are not NUL terminated and nothing in
+here allocates, so slicing, splitting and comparing are free. A view is only
+valid for as long as the characters it points at.
+*/
+typedef struct {
+    const char *s;
+    size_t length;
+} StrView;
+
+// returned by the find functions when there is no match
+#define VIEW_NPOS ((size_t)-1)
+
+
+StrView view(const char *);           // over a NUL terminated C string
+StrView view_str(const String *);     // over a String, see cstr()
+
+/* length characters from start, clamped to the end of the view */
+StrView subview(StrView, size_t start, size_t length);
+
+size_t view_find(StrView, char);               // first index of char or VIEW_NPOS
+size_t view_find_str(StrView, StrView needle);  // first index of needle or VIEW_NPOS
+
+StrView view_trim(StrView);  // without leading and trailing whitespace
+
+int view_cmp(StrView, StrView);  // <0, 0 or >0, like strcmp
+bool view_eq(StrView, StrView);
+bool view_prefix(StrView, StrView prefix);
+bool view_suffix(StrView, StrView suffix);
+
+/* hash_fnv1a(v, 0), the same hash the hash table uses for its keys */
+uint64_t view_hash(StrView);
+
+
+/*
+Split a view on a single character without copying, e.g.
+
+    SplitIter it = view_split(line, '=');
+    StrView part;
+    while (split_next(&it, &part))
+        ...
+
+Like str_split(), empty pieces between separators are skipped.
+*/
+typedef struct {
+    StrView rest;
+    char sep;
+} SplitIter;
+
+SplitIter view_split(StrView, char sep);
+bool split_next(SplitIter *, StrView *part);
+
+#endif
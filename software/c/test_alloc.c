@@ -0,0 +1,230 @@
+/* Tracked allocator tests. */
+#include <assert.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "alloc.h"
+
+
+void test_alloc_free()
+{
+    mem_stats_reset();
+
+    char *a = mem_alloc(100);
+    char *b = mem_calloc(10, 4);
+
+    assert(a && b);
+    for (size_t i = 0; i < 40; i++)
+        assert(b[i] == 0);
+
+    MemStats stats = mem_stats();
+    assert(stats.allocs == 2);
+    assert(stats.bytes == 140);
+    assert(stats.live == 140);
+    assert(stats.peak == 140);
+
+    mem_free(a);
+    mem_free(b);
+    mem_free(NULL);
+
+    stats = mem_stats();
+    assert(stats.frees == 2);
+    assert(stats.live == 0);
+    assert(stats.peak == 140);
+}
+
+
+void test_realloc()
+{
+    mem_stats_reset();
+
+    char *a = mem_realloc(NULL, 8);
+    memcpy(a, "0123456", 8);
+
+    a = mem_realloc(a, 4096);
+    assert(strcmp(a, "0123456") == 0);
+    assert(mem_stats().live == 4096);
+
+    a = mem_realloc(a, 16);
+    assert(strcmp(a, "0123456") == 0);
+    assert(mem_stats().live == 16);
+    assert(mem_stats().peak == 4096);
+    assert(mem_stats().reallocs == 2);
+
+    mem_free(a);
+    assert(mem_stats().live == 0);
+}
+
+
+void test_arena()
+{
+    mem_stats_reset();
+
+    char *outside = mem_alloc(10);
+
+    Arena *job = arena_begin();
+
+    // leaked, freed and realloc'ed blocks, all gone once the arena ends
+    for (int i = 0; i < 100; i++)
+        mem_alloc(32);
+
+    mem_free(mem_alloc(64));
+
+    char *grown = mem_alloc(1);
+    grown = mem_realloc(grown, 1000);
+
+    assert(mem_stats().live == 10 + 100 * 32 + 1000);
+
+    arena_end(job);
+
+    MemStats stats = mem_stats();
+    assert(stats.live == 10);
+    assert(stats.frees == 1 + 100 + 1);
+
+    // blocks from before the arena are untouched
+    memset(outside, 'x', 10);
+    mem_free(outside);
+    assert(mem_stats().live == 0);
+}
+
+
+void test_arena__nested()
+{
+    mem_stats_reset();
+
+    Arena *outer = arena_begin();
+    mem_alloc(100);
+
+    Arena *inner = arena_begin();
+    mem_alloc(10);
+    arena_end(inner);
+
+    assert(mem_stats().live == 100);
+
+    // after the inner one ends, allocations go to the outer one again
+    mem_alloc(5);
+    arena_end(outer);
+
+    assert(mem_stats().live == 0);
+}
+
+
+void test_arena__repeated()
+{
+    mem_stats_reset();
+
+    // the same job over and over stays flat
+    for (int job = 0; job < 50; job++) {
+        Arena *arena = arena_begin();
+
+        for (int i = 0; i < 20; i++)
+            mem_alloc(128);
+
+        arena_end(arena);
+    }
+
+    assert(mem_stats().live == 0);
+    assert(mem_stats().peak == 20 * 128);
+}
+
+
+static char PHASES[4][16];
+static MemStats PHASE_STATS[4];
+static int PHASE_COUNT = 0;
+
+
+static void record(const char *phase, MemStats stats)
+{
+    snprintf(PHASES[PHASE_COUNT], sizeof(PHASES[0]), "%s", phase);
+    PHASE_STATS[PHASE_COUNT++] = stats;
+}
+
+
+void test_phases()
+{
+    mem_hook(record);
+    mem_phase("before");
+    PHASE_COUNT = 0;
+
+    char *a = mem_alloc(100);
+    char *b = mem_alloc(200);
+    mem_phase("first");
+
+    mem_free(b);
+    char *c = mem_alloc(50);
+    mem_phase("second");
+
+    mem_free(a);
+    mem_free(c);
+    mem_phase("third");
+
+    mem_hook(NULL);
+    mem_phase("unreported");
+
+    assert(PHASE_COUNT == 3);
+    assert(strcmp(PHASES[0], "first") == 0);
+    assert(strcmp(PHASES[2], "third") == 0);
+
+    assert(PHASE_STATS[0].allocs == 2);
+    assert(PHASE_STATS[0].bytes == 300);
+    assert(PHASE_STATS[0].live == 300);
+    assert(PHASE_STATS[0].peak == 300);
+
+    // the peak is for the phase alone, it starts at what was live
+    assert(PHASE_STATS[1].allocs == 1);
+    assert(PHASE_STATS[1].frees == 1);
+    assert(PHASE_STATS[1].live == 150);
+    assert(PHASE_STATS[1].peak == 300);
+
+    assert(PHASE_STATS[2].frees == 2);
+    assert(PHASE_STATS[2].live == 0);
+    assert(PHASE_STATS[2].peak == 150);
+}
+
+
+static jmp_buf FAILED;
+static char *FAIL_MESSAGE = NULL;
+
+
+static void on_fail(char *message)
+{
+    FAIL_MESSAGE = message;
+    longjmp(FAILED, 1);
+}
+
+
+void test_on_fail()
+{
+    mem_on_fail(on_fail);
+
+    // the handler takes over, mem_fail() never gets to exit
+    if (setjmp(FAILED) == 0) {
+        mem_fail("Out of memory");
+        assert(0);
+    }
+
+    assert(strcmp(FAIL_MESSAGE, "Out of memory") == 0);
+
+    mem_on_fail(NULL);
+}
+
+
+void tests()
+{
+    test_alloc_free();
+    test_realloc();
+    test_arena();
+    test_arena__nested();
+    test_arena__repeated();
+    test_phases();
+    test_on_fail();
+}
+
+
+int main()
+{
+    tests();
+    printf("----- ALLOC TESTS PASS ------\n");
+    return 0;
+}
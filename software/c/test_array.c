@@ -1,6 +1,7 @@
 /* Array tests. */
 #include <assert.h>
 
+#include "alloc.h"
 #include "array.h"
 
 int issame(const char w1[], const char w2[]) {
@@ -105,7 +106,8 @@ void test_push__resize()
         push(n, &i);
 
     assert(n->length == 15);
-    assert(n->_total_size == 32);
+    // arrays only grow once full
+    assert(n->_total_size == 16);
     assert(&n->items[0] != NULL);
     assert(n->items[0].data != NULL);
 
@@ -129,17 +131,18 @@ void test_push()
 
     // start tests, use a big number to ensure resize works
     assert(n->length == 999);
-    assert(n->_total_size == 2048);
+    assert(n->_total_size == 1024);
 
-    Array *tmp = n;
-    for (size_t i = 0; i < n->length; i++, tmp->items++) {
-        Item item = *tmp->items;
+    Item *tmp = n->items;
+    for (size_t i = 0; i < n->length; i++, tmp++) {
+        Item item = *tmp;
         assert(*(int *)item.data == (int)(i + 1));
     }
 
-    // ensure pointer is nulled after cleanup
+    // both the struct and its items block are given back
+    mem_stats_reset();
     freearray(n);
-    assert(n->items == NULL);
+    assert(mem_stats().frees == 2);
 }
 
 
@@ -163,9 +166,7 @@ void test_pop__basic()
     for (size_t i = 0; i < 10; i++)
         assert(!pop(n).data);
 
-    // ensure pointer is nulled after cleanup
     freearray(n);
-    assert(n->items == NULL);
 }
 
 
@@ -180,9 +181,9 @@ void test_pop__overwrite()
     assert(n->length == 20);
     assert(n->_total_size == 32);
 
-    Array *tmp = n;
-    for (size_t i = 0; i < n->length; i++, tmp->items++) {
-        Item item = *tmp->items;
+    Item *tmp = n->items;
+    for (size_t i = 0; i < n->length; i++, tmp++) {
+        Item item = *tmp;
         assert(*(int *)item.data == (int)(i + 1));
     }
 
@@ -194,9 +195,9 @@ void test_pop__overwrite()
     for (int i = 100; i < 110; i++)
         push(n, &i);
 
-    Array *tmp2 = n;
-    for (size_t i = 0; i < n->length; i++, tmp2->items++) {
-        Item item = *tmp2->items;
+    Item *tmp2 = n->items;
+    for (size_t i = 0; i < n->length; i++, tmp2++) {
+        Item item = *tmp2;
         assert(*(int *)item.data == (int)(i + 100));
     }
 
@@ -204,9 +205,7 @@ void test_pop__overwrite()
     assert(n->length == 10);
     assert(n->_total_size == 32);
 
-    // ensure pointer is nulled after cleanup
     freearray(n);
-    assert(n->items == NULL);
 }
 
 
@@ -236,16 +235,14 @@ void test_iterator__int()
 
     // start tests, use a big number to ensure resize works
     assert(n->length == 999);
-    assert(n->_total_size == 2048);
+    assert(n->_total_size == 1024);
 
     int i = 1;  // counter to assert against in tests
     AIT tmp = iter(n);
     while (array_next(&tmp))
         assert(*(int *)tmp.data == i++);
 
-    // ensure pointer is nulled after cleanup
     freearray(n);
-    assert(n->items == NULL);
 }
 
 
@@ -262,14 +259,114 @@ void test_iterator__char()
     while (array_next(&tmp))
         assert(issame((char *)tmp.data, test_strs[i++]));
 
-    // ensure pointer is nulled after cleanup
     freearray(n);
-    assert(n->items == NULL);
 
 
 }
 
 
+void test_push__full()
+{
+    Array *n = newarr(newitem_int);
+
+    for (int i = 0; i < 16; i++)
+        push(n, &i);
+
+    assert(n->length == 16);
+    assert(n->_total_size == 16);
+
+    int i = 16;
+    push(n, &i);
+
+    assert(n->length == 17);
+    assert(n->_total_size == 32);
+
+    // grown slots start empty
+    for (size_t j = n->length; j < n->_total_size; j++)
+        assert(n->items[j].data == NULL);
+
+    for (size_t j = 0; j < n->length; j++)
+        assert(*(int *)n->items[j].data == (int)j);
+}
+
+
+void test_newarr_sized()
+{
+    mem_stats_reset();
+
+    Array *n = newarr_sized(newitem_int, 1000);
+    assert(n->length == 0);
+    assert(n->_total_size == 1000);
+
+    for (int i = 0; i < 1000; i++)
+        push(n, &i);
+
+    // sized up front, so no reallocs
+    assert(n->_total_size == 1000);
+    assert(mem_stats().reallocs == 0);
+    assert(mem_stats().allocs == 2);
+
+    // an empty array still has room for one item
+    Array *empty = newarr_sized(newitem_int, 0);
+    assert(empty->_total_size == 1);
+}
+
+
+void test_growth()
+{
+    Array *n = newarr(newitem_int);
+
+    // factors of 1 or less would never grow, they are ignored
+    array_growth(n, 1.0);
+    assert(n->growth > 1);
+
+    array_growth(n, 1.5);
+
+    for (int i = 0; i < 17; i++)
+        push(n, &i);
+
+    assert(n->_total_size == 24);
+
+    // a factor too small to add a whole slot still grows by one
+    Array *small = newarr_sized(newitem_int, 1);
+    array_growth(small, 1.1);
+
+    for (int i = 0; i < 3; i++)
+        push(small, &i);
+
+    assert(small->_total_size == 3);
+}
+
+
+void test_shrink()
+{
+    Array *n = newarr(newitem_int);
+
+    for (int i = 0; i < 100; i++)
+        push(n, &i);
+
+    assert(n->_total_size == 128);
+
+    mem_stats_reset();
+    array_shrink(n);
+
+    assert(n->_total_size == 100);
+    assert(mem_stats().reallocs == 1);
+
+    for (size_t i = 0; i < n->length; i++)
+        assert(*(int *)n->items[i].data == (int)i);
+
+    // already tight, nothing to do
+    array_shrink(n);
+    assert(mem_stats().reallocs == 1);
+
+    // pushing after a shrink grows again
+    int i = 100;
+    push(n, &i);
+    assert(n->_total_size == 200);
+}
+
+
 void test_pop() {
     test_pop__basic();
     test_pop__overwrite();
@@ -289,6 +386,10 @@ void tests() {
     test_push__basic2();
     test_push__resize();
     test_push();
+    test_push__full();
+    test_newarr_sized();
+    test_growth();
+    test_shrink();
     test_pop();
     test_str_array();
     test_iterator();
@@ -0,0 +1,221 @@
+/* Concurrent hash table tests. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "chash.h"
+
+
+#define THREADS 8
+#define KEYS 5000
+
+
+static char KEY_NAMES[KEYS][32];
+
+
+static void make_keys(void)
+{
+    for (int i = 0; i < KEYS; i++)
+        sprintf(KEY_NAMES[i], "Main.fibonacci$IF_TRUE%d", i);
+}
+
+
+void test_basic()
+{
+    CHT *table = chash_create(16);
+    size_t value;
+
+    assert(chash_length(table) == 0);
+    assert(!chash_get(table, "LOOP", &value));
+
+    assert(chash_set(table, "LOOP", 4));
+    assert(chash_get(table, "LOOP", &value));
+    assert(value == 4);
+
+    // overwrite
+    assert(chash_set(table, "LOOP", 10));
+    assert(chash_get(table, "LOOP", &value));
+    assert(value == 10);
+    assert(chash_length(table) == 1);
+
+    // IDs count up from first_id, existing keys keep their value
+    assert(chash_get_or_insert(table, "i") == 16);
+    assert(chash_get_or_insert(table, "sum") == 17);
+    assert(chash_get_or_insert(table, "i") == 16);
+    assert(chash_get_or_insert(table, "LOOP") == 10);
+    assert(chash_length(table) == 3);
+
+    chash_destroy(table);
+}
+
+
+void test_resize()
+{
+    CHT *table = chash_create(0);
+    size_t value;
+
+    for (int i = 0; i < KEYS; i++)
+        assert(chash_set(table, KEY_NAMES[i], (size_t)i * 3));
+
+    assert(chash_length(table) == KEYS);
+
+    for (int i = 0; i < KEYS; i++) {
+        assert(chash_get(table, KEY_NAMES[i], &value));
+        assert(value == (size_t)i * 3);
+    }
+
+    assert(!chash_get(table, "Main.fibonacci$IF_TRUE", &value));
+
+    chash_destroy(table);
+}
+
+
+typedef struct {
+    CHT *table;
+    int id;
+    size_t ids[KEYS];
+} Worker;
+
+
+/* every thread interns every key, each starting at a different one */
+static void * intern_all(void *arg)
+{
+    Worker *w = arg;
+    int start = w->id * (KEYS / THREADS);
+
+    for (int i = 0; i < KEYS; i++) {
+        int k = (start + i) % KEYS;
+        w->ids[k] = chash_get_or_insert(w->table, KEY_NAMES[k]);
+    }
+
+    return NULL;
+}
+
+
+void test_get_or_insert__contended()
+{
+    static Worker workers[THREADS];
+    pthread_t threads[THREADS];
+
+    CHT *table = chash_create(16);
+
+    for (int t = 0; t < THREADS; t++) {
+        workers[t].table = table;
+        workers[t].id = t;
+        pthread_create(&threads[t], NULL, intern_all, &workers[t]);
+    }
+
+    for (int t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+
+    assert(chash_length(table) == KEYS);
+
+    // each key got one ID and every thread saw that same one
+    static char seen[KEYS];
+    for (int k = 0; k < KEYS; k++) {
+        size_t id = workers[0].ids[k];
+
+        for (int t = 1; t < THREADS; t++)
+            assert(workers[t].ids[k] == id);
+
+        // and no ID was skipped or handed out twice
+        assert(id >= 16 && id < 16 + KEYS);
+        assert(!seen[id - 16]);
+        seen[id - 16] = 1;
+    }
+
+    // nothing was taken that didn't end up in the table
+    assert(chash_get_or_insert(table, "one more") == 16 + KEYS);
+
+    chash_destroy(table);
+}
+
+
+typedef struct {
+    CHT *table;
+    int id;
+    size_t found;
+} Mixed;
+
+
+/* writers each add their share of the keys, value derived from the key */
+static void * write_some(void *arg)
+{
+    Mixed *m = arg;
+
+    for (int k = m->id; k < KEYS; k += THREADS / 2)
+        assert(chash_set(m->table, KEY_NAMES[k], (size_t)k * 7 + 1));
+
+    return NULL;
+}
+
+
+/* readers keep looking while the writers (and resizes) are going on */
+static void * read_all(void *arg)
+{
+    Mixed *m = arg;
+    size_t value;
+
+    for (int round = 0; round < 20; round++) {
+        for (int k = 0; k < KEYS; k++) {
+            if (chash_get(m->table, KEY_NAMES[k], &value)) {
+                // a key is never visible without its value
+                assert(value == (size_t)k * 7 + 1);
+                m->found++;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+void test_read_while_writing()
+{
+    Mixed mixed[THREADS];
+    pthread_t threads[THREADS];
+
+    CHT *table = chash_create(0);
+
+    for (int t = 0; t < THREADS; t++) {
+        mixed[t].table = table;
+        mixed[t].id = t % (THREADS / 2);
+        mixed[t].found = 0;
+        pthread_create(&threads[t], NULL, t < THREADS / 2 ? write_some : read_all, &mixed[t]);
+    }
+
+    for (int t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+
+    assert(chash_length(table) == KEYS);
+
+    size_t value;
+    for (int k = 0; k < KEYS; k++) {
+        assert(chash_get(table, KEY_NAMES[k], &value));
+        assert(value == (size_t)k * 7 + 1);
+    }
+
+    chash_destroy(table);
+}
+
+
+void tests()
+{
+    make_keys();
+
+    test_basic();
+    test_resize();
+    test_get_or_insert__contended();
+    test_read_while_writing();
+}
+
+
+int main()
+{
+    tests();
+    printf("----- CHASH TESTS PASS ------\n");
+    return 0;
+}
@@ -0,0 +1,252 @@
+/* Assembler daemon tests: a forked asmd serving real requests. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "daemon.h"
+
+
+// connections the forked daemon answers, one per request() below
+#define REQUESTS 13
+
+
+static const char *PROGRAM =
+    "// adds 2 and 3\n"
+    "@2\n"
+    "D=A\n"
+    "(ADD)\n"
+    "@3\n"
+    "D=D+A\n"
+    "@sum\n"
+    "M=D\n";
+
+static const char *PROGRAM_HACK =
+    "0000000000000010\n"
+    "1110110000010000\n"
+    "0000000000000011\n"
+    "1110000010010000\n"
+    "0000000000010000\n"
+    "1110001100001000\n";
+
+
+static char SOCKET[64];
+
+
+static void request(const char *command, const char *input, AsmdReply *reply)
+{
+    assert(asmd_request(SOCKET, command, input, strlen(input), reply) == 0);
+}
+
+
+void test_assemble()
+{
+    AsmdReply reply;
+    request("assemble", PROGRAM, &reply);
+
+    assert(reply.ok);
+    assert(reply.size[0] == strlen(PROGRAM_HACK));
+    assert(memcmp(reply.output[0], PROGRAM_HACK, reply.size[0]) == 0);
+
+    assert(reply.size[1] == strlen("2 ADD\n"));
+    assert(memcmp(reply.output[1], "2 ADD\n", reply.size[1]) == 0);
+
+    // source map: 16 byte header, then 12 bytes per word
+    assert(reply.size[2] == 16 + 6 * 12);
+    assert(memcmp(reply.output[2], "HSMP", 4) == 0);
+
+    asmd_reply_free(&reply);
+
+    // the second time comes from the cache, and is the same
+    request("assemble", PROGRAM, &reply);
+    assert(reply.ok);
+    assert(memcmp(reply.output[0], PROGRAM_HACK, reply.size[0]) == 0);
+    asmd_reply_free(&reply);
+}
+
+
+void test_errors()
+{
+    AsmdReply reply;
+
+    request("assemble", "D=Q\n", &reply);
+    assert(!reply.ok);
+    assert(strcmp(reply.error, "Invalid instruction: D=Q") == 0);
+    asmd_reply_free(&reply);
+
+    // 2^64 + 5, which wrapped around to 5 when it was read into a long
+    request("assemble", "@18446744073709551621\n", &reply);
+    assert(!reply.ok);
+    assert(strcmp(reply.error, "Invalid constant: @18446744073709551621") == 0);
+    asmd_reply_free(&reply);
+
+    request("compile", "class Main {}\n", &reply);
+    assert(!reply.ok);
+    assert(reply.error != NULL);
+    asmd_reply_free(&reply);
+
+    // a failed job leaves nothing behind for the next one: sum is still
+    // the first variable, at 16
+    request("assemble", "@sum\nM=0\n", &reply);
+    assert(reply.ok);
+    assert(memcmp(reply.output[0], "0000000000010000\n", 17) == 0);
+    asmd_reply_free(&reply);
+}
+
+
+void test_empty()
+{
+    AsmdReply reply;
+
+    request("assemble", "", &reply);
+    assert(reply.ok);
+    assert(reply.size[0] == 0);
+    assert(reply.size[1] == 0);
+    asmd_reply_free(&reply);
+}
+
+
+void test_stalled_client()
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SOCKET);
+
+    // a client that stops halfway through its input
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    assert(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(write(fd, "assemble 100\n@2\n", 16) == 16);
+
+    // is dropped after the timeout, and the next client is answered
+    AsmdReply reply;
+    request("assemble", PROGRAM, &reply);
+    assert(reply.ok);
+    asmd_reply_free(&reply);
+
+    close(fd);
+}
+
+
+void test_trickling_client()
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SOCKET);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    assert(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+
+    // a client that never stalls long enough for any one read to time
+    // out, but sends a byte every 100ms for 4 timeouts, still short of the
+    // 100 it promised
+    pid_t pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+        struct timespec pause = {0, 100 * 1000 * 1000};
+
+        if (send(fd, "assemble 100\n", 13, MSG_NOSIGNAL) == 13) {
+            for (int i = 0; i < 4 * ASMD_TIMEOUT_MS / 100; i++) {
+                nanosleep(&pause, NULL);
+
+                if (send(fd, "@", 1, MSG_NOSIGNAL) != 1)
+                    break;
+            }
+        }
+
+        _exit(0);
+    }
+
+    close(fd);
+
+    // is dropped when its request runs out of time, and the next client
+    // is answered well before the trickle would have ended
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+
+    AsmdReply reply;
+    request("assemble", PROGRAM, &reply);
+    assert(reply.ok);
+    asmd_reply_free(&reply);
+
+    gettimeofday(&end, NULL);
+    long elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_usec - start.tv_usec) / 1000;
+    assert(elapsed_ms < 2 * ASMD_TIMEOUT_MS);
+
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+}
+
+
+void test_second_daemon()
+{
+    // the running daemon answers, so its socket is left alone
+    assert(asmd_listen(SOCKET) == -1);
+
+    AsmdReply reply;
+    request("assemble", PROGRAM, &reply);
+    assert(reply.ok);
+    asmd_reply_free(&reply);
+}
+
+
+void test_no_daemon()
+{
+    AsmdReply reply;
+    assert(asmd_request("/tmp/no-such-asmd.sock", "assemble", "", 0, &reply) == -1);
+}
+
+
+void tests()
+{
+    snprintf(SOCKET, sizeof(SOCKET), "/tmp/asmd-test-%ld.sock", (long)getpid());
+
+    // listen before forking, so no request can beat the server to it
+    int fd = asmd_listen(SOCKET);
+    assert(fd >= 0);
+
+    pid_t pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+        asmd_serve(fd, REQUESTS);
+        _exit(0);
+    }
+
+    close(fd);
+
+    test_assemble();
+    test_errors();
+    test_empty();
+    test_stalled_client();
+    test_trickling_client();
+    test_second_daemon();
+    test_no_daemon();
+
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    unlink(SOCKET);
+}
+
+
+int main()
+{
+    tests();
+    printf("----- DAEMON TESTS PASS ------\n");
+    return 0;
+}
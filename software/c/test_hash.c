@@ -1,5 +1,7 @@
 #include <assert.h>
+#include <string.h>
 
+#include "alloc.h"
 #include "hash.h"
 
 
@@ -17,6 +19,15 @@ int ____issame(const char w1[], const char w2[]) {
 }
 
 
+/* a value the table can own, see set() */
+char * owned(const char *s)
+{
+    char *copy = mem_alloc(strlen(s) + 1);
+    strcpy(copy, s);
+    return copy;
+}
+
+
 HT * prefill_hash()
 {
     HT *map = create();
@@ -78,6 +89,24 @@ void test_get()
 }
 
 
+void test_get_view()
+{
+    HT *map = prefill_hash();
+
+    // a slice of a longer line finds the same entry as a C string
+    StrView line = view("AMD=M+1;JMP");
+    assert(____issame((char *)get_view(map, subview(line, 0, 3)), "111"));
+    assert(____issame((char *)get_view(map, subview(line, 0, 2)), "101"));
+    assert(____issame((char *)get_view(map, subview(line, 0, 1)), "100"));
+
+    // a view that is only a prefix of a key is not that key, and the other
+    // way round
+    assert(get_view(map, subview(view("null"), 0, 3)) == NULL);
+    assert(get_view(map, view("AMDX")) == NULL);
+    assert(get_view(map, view("")) == NULL);
+}
+
+
 void test_nonexisting_key()
 {
     HT *table = create();
@@ -90,22 +119,26 @@ void test_overwrite()
     HT *table = create();
 
     char *key = "test-key";
-    int value = 100;
 
-    assert(set(table, key, &value) != NULL);
-
-    int result = *(int *)get(table, "test-key");
-    assert(result == 100);
+    assert(set(table, key, owned("100")) != NULL);
+    assert(____issame(get(table, "test-key"), "100"));
 
-    // overwrite the keys value
-    value = 300;
+    MemStats before = mem_stats();
 
-    assert(set(table, key, &value) != NULL);
+    // overwrite the keys value, the table frees the one it had
+    assert(set(table, key, owned("300")) != NULL);
     assert(length(table) == 1);
+    assert(mem_stats().frees == before.frees + 1);
 
     // ensure upadated result is correct
-    assert(*(int *)get(table, "test-key") == 300);
+    assert(____issame(get(table, "test-key"), "300"));
 
+    // setting the value it already has frees nothing
+    before = mem_stats();
+    assert(set(table, key, get(table, key)) != NULL);
+    assert(mem_stats().frees == before.frees);
+
+    destroy(table);
 }
 
 
@@ -126,14 +159,335 @@ void test_iter()
 }
 
 
+void test_get_static()
+{
+    // what gen_tables.c does, by hand: one key in a table of four
+    StaticItem slots[4] = {{NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}};
+    StaticHT table = {slots, 3, 7};
+
+    slots[hash_wy(view("AMD"), 7) & 3].key = "AMD";
+    slots[hash_wy(view("AMD"), 7) & 3].value = 7;
+
+    assert(get_static(&table, view("AMD"))->value == 7);
+    assert(get_static(&table, subview(view("AMD=M+1"), 0, 3))->value == 7);
+
+    // prefixes and longer keys landing in the same slot don't match
+    assert(get_static(&table, view("AM")) == NULL);
+    assert(get_static(&table, view("AMDX")) == NULL);
+    assert(get_static(&table, view("")) == NULL);
+}
+
+
+void test_export()
+{
+    HT *map = prefill_hash();
+    const char *path = "hash_export.tmp";
+
+    assert(hash_export(map, path) == 0);
+
+    HTFile *file = hash_file_open(path);
+    assert(file != NULL);
+    assert(hash_file_length(file) == 8);
+
+    // sorted by key, whatever order they went in
+    const char *sorted[] = {"A", "AD", "AM", "AMD", "D", "M", "MD", "null"};
+    for (size_t i = 0; i < 8; i++) {
+        assert(____issame(hash_file_key(file, i), sorted[i]));
+        assert(____issame(hash_file_value(file, i), (char *)get(map, sorted[i])));
+    }
+
+    assert(hash_file_key(file, 8) == NULL);
+
+    assert(____issame(hash_file_get(file, "AMD"), "111"));
+    assert(____issame(hash_file_get(file, "null"), "000"));
+    assert(hash_file_get(file, "AMDX") == NULL);
+    assert(hash_file_get(file, "") == NULL);
+
+    hash_file_close(file);
+
+    // an empty table is a valid, empty file
+    assert(hash_export(create(), path) == 0);
+    file = hash_file_open(path);
+    assert(file != NULL);
+    assert(hash_file_length(file) == 0);
+    assert(hash_file_get(file, "A") == NULL);
+    hash_file_close(file);
+
+    remove(path);
+}
+
+
+void test_export__invalid()
+{
+    const char *path = "hash_export.tmp";
+
+    assert(hash_file_open("does/not/exist") == NULL);
+
+    // too short for a header
+    FILE *fp = fopen(path, "wb");
+    fputs("HTEX", fp);
+    fclose(fp);
+    assert(hash_file_open(path) == NULL);
+
+    // cut off in the string table
+    assert(hash_export(prefill_hash(), path) == 0);
+    fp = fopen(path, "rb");
+    char buffer[256];
+    size_t size = fread(buffer, 1, sizeof(buffer), fp);
+    fclose(fp);
+
+    fp = fopen(path, "wb");
+    fwrite(buffer, 1, size - 1, fp);
+    fclose(fp);
+    assert(hash_file_open(path) == NULL);
+
+    // wrong magic
+    buffer[0] = 'X';
+    fp = fopen(path, "wb");
+    fwrite(buffer, 1, size, fp);
+    fclose(fp);
+    assert(hash_file_open(path) == NULL);
+
+    remove(path);
+}
+
+
+/* fill with keys "0".."count-1", each value a copy of its key */
+void fill(HT *table, int count)
+{
+    char key[16];
+
+    for (int i = 0; i < count; i++) {
+        sprintf(key, "%d", i);
+        assert(set(table, key, owned(key)) != NULL);
+    }
+}
+
+
+void check(HT *table, int count)
+{
+    char key[16];
+
+    assert(length(table) == (size_t)count);
+
+    for (int i = 0; i < count; i++) {
+        sprintf(key, "%d", i);
+        assert(____issame((char *)get(table, key), key));
+    }
+
+    assert(get(table, "missing") == NULL);
+}
+
+
+void test_iter__insertion_order()
+{
+    HT *table = create();
+    fill(table, 1000);
+
+    // overwriting keeps a key where it was
+    set(table, "7", owned("seven"));
+
+    HTI it = iterator(table);
+    char key[16];
+
+    for (int i = 0; i < 1000; i++) {
+        assert(next(&it));
+
+        sprintf(key, "%d", i);
+        assert(____issame(it.key, key));
+        assert(____issame((char *)it.value, i == 7 ? "seven" : key));
+    }
+
+    assert(!next(&it));
+}
+
+
+void test_overwrite__full()
+{
+    HT *table = create();
+
+    // the most a 16 slot table holds
+    fill(table, 12);
+
+    mem_stats_reset();
+
+    // overwriting makes no new entry, so it needs no room; the only alloc
+    // is the new value and the only free the value it replaces
+    assert(set(table, "3", owned("three")) != NULL);
+    assert(____issame((char *)get(table, "3"), "three"));
+
+    MemStats stats = mem_stats();
+    assert(stats.allocs == 1);
+    assert(stats.reallocs == 0);
+    assert(stats.frees == 1);
+
+    // a new key does
+    assert(set(table, "12", owned("12")) != NULL);
+    assert(mem_stats().reallocs == 1);
+}
+
+
+void test_resize()
+{
+    HT *table = create();
+
+    mem_stats_reset();
+    fill(table, 1000);
+    check(table, 1000);
+
+    // two allocs per entry, its key and value, plus one per new index:
+    // 16 -> 2048 is 7 doublings. The entries are realloc'ed and keep their
+    // keys.
+    MemStats stats = mem_stats();
+    assert(stats.allocs == 2000 + 7);
+    assert(stats.reallocs == 7);
+    assert(stats.frees == 7);
+}
+
+
+void test_create_sized()
+{
+    mem_stats_reset();
+
+    HT *table = create_sized(1000);
+    fill(table, 1000);
+    check(table, 1000);
+
+    // the table, its index and entries, then only the keys and values
+    MemStats stats = mem_stats();
+    assert(stats.allocs == 3 + 2000);
+    assert(stats.frees == 0);
+
+    HT *empty = create_sized(0);
+    fill(empty, 3);
+    check(empty, 3);
+}
+
+
+void test_growth()
+{
+    HT *table = create();
+    hash_growth(table, 3);
+
+    mem_stats_reset();
+    fill(table, 1000);
+    check(table, 1000);
+
+    // rounded up to 4, so 16 -> 64 -> 256 -> 1024 -> 4096 is 4 resizes
+    assert(mem_stats().allocs == 2000 + 4);
+}
+
+
+void test_shrink()
+{
+    HT *table = create_sized(10000);
+    fill(table, 100);
+
+    mem_stats_reset();
+    hash_shrink(table);
+    check(table, 100);
+
+    assert(mem_stats().allocs == 1);
+    assert(mem_stats().frees == 1);
+
+    // already as small as it can be
+    hash_shrink(table);
+    assert(mem_stats().allocs == 1);
+
+    // still grows afterwards
+    HT *small = create_sized(0);
+    hash_shrink(small);
+    fill(small, 50);
+    check(small, 50);
+}
+
+
+void test_hash_functions()
+{
+    StrView key = view("PongGame.moveBall$IF_TRUE12");
+
+    // unseeded FNV-1a is what the views and the concurrent table use
+    assert(hash_fnv1a(key, 0) == view_hash(key));
+    assert(hash_fnv1a(key, 1) != hash_fnv1a(key, 0));
+
+    assert(hash_wy(key, 0) == hash_wy(key, 0));
+    assert(hash_wy(key, 7) != hash_wy(key, 0));
+
+    // every prefix, through all of the short key paths and the 16 byte
+    // loop, hashes differently
+    char text[] = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGH";
+    uint64_t seen[sizeof(text)];
+
+    for (size_t len = 0; len < sizeof(text); len++) {
+        seen[len] = hash_wy(subview(view(text), 0, len), 0);
+
+        for (size_t j = 0; j < len; j++)
+            assert(seen[j] != seen[len]);
+    }
+}
+
+
+void test_switch_hash_function()
+{
+    HT *table = create();
+    fill(table, 500);
+
+    hash_function(table, hash_wy, hash_random_seed());
+    check(table, 500);
+
+    // new keys go in with the new function too
+    fill(table, 1000);
+    check(table, 1000);
+
+    hash_function(table, hash_fnv1a, 0);
+    check(table, 1000);
+}
+
+
+void test_probe_stats()
+{
+    HT *table = create();
+
+    ProbeStats stats = hash_probe_stats(table);
+    assert(stats.entries == 0);
+    assert(stats.max == 0);
+
+    fill(table, 1000);
+    stats = hash_probe_stats(table);
+
+    assert(stats.entries == 1000);
+    assert(stats.max >= 1);
+    assert(stats.total >= stats.entries);
+
+    size_t sum = 0;
+    for (size_t i = 0; i < PROBE_BUCKETS; i++)
+        sum += stats.histogram[i];
+
+    assert(sum == stats.entries);
+}
+
+
 void tests()
 {
     test_create();
     test_set();
     test_get();
+    test_get_view();
     test_nonexisting_key();
     test_overwrite();
     test_iter();
+    test_iter__insertion_order();
+    test_overwrite__full();
+    test_resize();
+    test_create_sized();
+    test_growth();
+    test_shrink();
+    test_hash_functions();
+    test_switch_hash_function();
+    test_probe_stats();
+    test_get_static();
+    test_export();
+    test_export__invalid();
 }
 
 
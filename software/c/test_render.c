@@ -0,0 +1,61 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "render.h"
+
+
+void test_render_words()
+{
+    const uint16_t words[] = {0x0000, 0x0002, 0xEC10, 0xFFFF, 0x8001};
+    char out[sizeof(words) / sizeof(*words) * RENDER_LINE + 1];
+
+    memset(out, 'x', sizeof(out));
+
+    size_t n = render_words(words, sizeof(words) / sizeof(*words), out);
+
+    assert(n == sizeof(out) - 1);
+    assert(memcmp(out,
+        "0000000000000000\n"
+        "0000000000000010\n"
+        "1110110000010000\n"
+        "1111111111111111\n"
+        "1000000000000001\n", n) == 0);
+
+    // nothing past the last line
+    assert(out[n] == 'x');
+
+    assert(render_words(words, 0, out) == 0);
+}
+
+
+void test_render_every_word()
+{
+    char line[RENDER_LINE];
+
+    for (uint32_t w = 0; w <= 0xFFFF; w++) {
+        uint16_t word = (uint16_t)w;
+        render_words(&word, 1, line);
+
+        for (int bit = 0; bit < 16; bit++)
+            assert(line[bit] == (char)('0' + ((w >> (15 - bit)) & 1)));
+
+        assert(line[16] == '\n');
+    }
+}
+
+
+void tests()
+{
+    test_render_words();
+    test_render_every_word();
+}
+
+
+int main()
+{
+    tests();
+    printf("----- RENDER TESTS PASS ------\n");
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "srcmap.h"
+
+
+#define TEST_FILE "test_srcmap.map"
+
+
+void test_directive()
+{
+    SrcMap *map = srcmap_new();
+
+    assert(srcmap_directive(map, "// @src Main.vm:12") == 1);
+    assert(srcmap_directive(map, "    // @src Main.jack:3") == 1);
+    // the line number comes after the last ':'
+    assert(srcmap_directive(map, "// @src C:/Main.vm:7") == 1);
+
+    assert(srcmap_directive(map, "// a plain comment") == 0);
+    assert(srcmap_directive(map, "// @src Main.vm") == 0);
+    assert(srcmap_directive(map, "// @src Main.vm:") == 0);
+    assert(srcmap_directive(map, "// @src :12") == 0);
+    assert(srcmap_directive(map, "@src") == 0);
+
+    srcmap_free(map);
+}
+
+
+void test_roundtrip()
+{
+    SrcMap *map = srcmap_new();
+
+    // words before any directive have no origin
+    srcmap_add(map, 1);
+    srcmap_add(map, 2);
+
+    srcmap_directive(map, "// @src Main.vm:4");
+    srcmap_add(map, 5);
+
+    srcmap_directive(map, "// @src Sys.vm:9");
+    srcmap_add(map, 7);
+
+    // going back to a file reuses its name
+    srcmap_directive(map, "// @src Main.vm:5");
+    // enough words to make the entries grow
+    for (uint32_t i = 0; i < 1000; i++)
+        assert(srcmap_add(map, 100 + i) == 0);
+
+    assert(srcmap_length(map) == 1004);
+    assert(srcmap_write(map, TEST_FILE) == 0);
+    srcmap_free(map);
+
+    map = srcmap_open(TEST_FILE);
+    assert(map != NULL);
+    assert(srcmap_length(map) == 1004);
+
+    const SrcEntry *e = srcmap_lookup(map, 0);
+    assert(e->asm_line == 1);
+    assert(srcmap_file(map, e) == NULL);
+    assert(e->origin_line == 0);
+
+    e = srcmap_lookup(map, 2);
+    assert(e->asm_line == 5);
+    assert(strcmp(srcmap_file(map, e), "Main.vm") == 0);
+    assert(e->origin_line == 4);
+
+    e = srcmap_lookup(map, 3);
+    assert(e->asm_line == 7);
+    assert(strcmp(srcmap_file(map, e), "Sys.vm") == 0);
+    assert(e->origin_line == 9);
+
+    e = srcmap_lookup(map, 1003);
+    assert(e->asm_line == 1099);
+    assert(e->origin_line == 5);
+    assert(srcmap_file(map, e) == srcmap_file(map, srcmap_lookup(map, 2)));
+
+    assert(srcmap_lookup(map, 1004) == NULL);
+
+    srcmap_free(map);
+    remove(TEST_FILE);
+}
+
+
+void test_open_invalid()
+{
+    assert(srcmap_open("does-not-exist.map") == NULL);
+
+    // wrong magic
+    FILE *fp = fopen(TEST_FILE, "wb");
+    fputs("not a source map", fp);
+    fclose(fp);
+    assert(srcmap_open(TEST_FILE) == NULL);
+
+    // file size does not match what the header describes
+    SrcMap *map = srcmap_new();
+    srcmap_add(map, 1);
+    srcmap_add(map, 2);
+    assert(srcmap_write(map, TEST_FILE) == 0);
+    srcmap_free(map);
+
+    fp = fopen(TEST_FILE, "ab");
+    fputc(0, fp);
+    fclose(fp);
+    assert(srcmap_open(TEST_FILE) == NULL);
+
+    remove(TEST_FILE);
+}
+
+
+void tests()
+{
+    test_directive();
+    test_roundtrip();
+    test_open_invalid();
+}
+
+
+int main()
+{
+    tests();
+    printf("----- SRCMAP TESTS PASS ------\n");
+    return 0;
+}
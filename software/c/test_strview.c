@@ -0,0 +1,176 @@
+/* String view tests. */
+#include <assert.h>
+#include <stdio.h>
+
+#include "strview.h"
+
+
+/* compare a view with a C string */
+int sameview(StrView v, const char expected[])
+{
+    return view_eq(v, view(expected));
+}
+
+
+void test_view()
+{
+    StrView v = view("D=M");
+    assert(v.length == 3);
+    assert(sameview(v, "D=M"));
+
+    assert(view("").length == 0);
+
+    String w1 = newstr("AMD");
+    StrView v1 = view_str(&w1);
+    assert(v1.s == cstr(&w1));
+    assert(sameview(v1, "AMD"));
+
+    String w2 = newstr("a string much too long to be stored inline");
+    StrView v2 = view_str(&w2);
+    assert(v2.s == cstr(&w2));
+    assert(v2.length == w2.length);
+    freestr(w2);
+}
+
+
+void test_subview()
+{
+    StrView v = view("AM=M-1");
+
+    assert(sameview(subview(v, 0, 2), "AM"));
+    assert(sameview(subview(v, 3, 3), "M-1"));
+
+    // clamped to the end
+    assert(sameview(subview(v, 3, VIEW_NPOS), "M-1"));
+    assert(sameview(subview(v, 6, 1), ""));
+    assert(sameview(subview(v, 100, 1), ""));
+}
+
+
+void test_find()
+{
+    StrView v = view("D;JGT");
+
+    assert(view_find(v, ';') == 1);
+    assert(view_find(v, 'D') == 0);
+    assert(view_find(v, '=') == VIEW_NPOS);
+    assert(view_find(view(""), 'D') == VIEW_NPOS);
+
+    StrView line = view("@LOOP // jump back to LOOP");
+    assert(view_find_str(line, view("//")) == 6);
+    assert(view_find_str(line, view("LOOP")) == 1);
+    assert(view_find_str(line, view("back to LOOP")) == 14);
+    assert(view_find_str(line, view("LOOPS")) == VIEW_NPOS);
+    assert(view_find_str(line, view("")) == 0);
+    assert(view_find_str(view("ab"), view("abc")) == VIEW_NPOS);
+    // a partial match right before the real one
+    assert(view_find_str(view("aab"), view("ab")) == 1);
+}
+
+
+void test_trim()
+{
+    assert(sameview(view_trim(view("  @SP  ")), "@SP"));
+    assert(sameview(view_trim(view("\t0;JMP\r\n")), "0;JMP"));
+    assert(sameview(view_trim(view("M=D")), "M=D"));
+    assert(sameview(view_trim(view("   ")), ""));
+    assert(sameview(view_trim(view("")), ""));
+}
+
+
+void test_compare()
+{
+    assert(view_cmp(view("JEQ"), view("JEQ")) == 0);
+    assert(view_cmp(view("JEQ"), view("JGT")) < 0);
+    assert(view_cmp(view("JGT"), view("JEQ")) > 0);
+    // a prefix sorts before the longer string
+    assert(view_cmp(view("AM"), view("AMD")) < 0);
+    assert(view_cmp(view("AMD"), view("AM")) > 0);
+    assert(view_cmp(view(""), view("")) == 0);
+
+    assert(view_eq(view("M"), view("M")));
+    assert(!view_eq(view("M"), view("MD")));
+    assert(view_eq(subview(view("MD"), 0, 1), view("M")));
+}
+
+
+void test_prefix_suffix()
+{
+    StrView v = view("Main.fibonacci$IF_TRUE0");
+
+    assert(view_prefix(v, view("Main.")));
+    assert(view_prefix(v, view("")));
+    assert(view_prefix(v, v));
+    assert(!view_prefix(v, view("Sys.")));
+    assert(!view_prefix(view("Main"), view("Main.")));
+
+    assert(view_suffix(v, view("$IF_TRUE0")));
+    assert(view_suffix(v, view("")));
+    assert(!view_suffix(v, view("$IF_TRUE1")));
+    assert(!view_suffix(view("0"), view("E0")));
+}
+
+
+void test_hash()
+{
+    // equal characters hash the same, wherever they come from
+    StrView whole = view("D+M");
+    StrView slice = subview(view("AM=D+M;JMP"), 3, 3);
+
+    assert(view_hash(whole) == view_hash(slice));
+    assert(view_hash(whole) != view_hash(view("D+A")));
+}
+
+
+void test_split()
+{
+    const char *expected[] = {"AM", "M-1"};
+
+    SplitIter it = view_split(view("AM=M-1"), '=');
+    StrView part;
+    int i = 0;
+
+    while (split_next(&it, &part))
+        assert(sameview(part, expected[i++]));
+
+    assert(i == 2);
+
+    // like str_split, empty pieces are skipped
+    const char *words[] = {"a", "b", "c"};
+
+    it = view_split(view("  a b   c "), ' ');
+    i = 0;
+    while (split_next(&it, &part))
+        assert(sameview(part, words[i++]));
+
+    assert(i == 3);
+
+    it = view_split(view(""), ' ');
+    assert(!split_next(&it, &part));
+
+    it = view_split(view("0;JMP"), '=');
+    assert(split_next(&it, &part));
+    assert(sameview(part, "0;JMP"));
+    assert(!split_next(&it, &part));
+}
+
+
+void tests()
+{
+    test_view();
+    test_subview();
+    test_find();
+    test_trim();
+    test_compare();
+    test_prefix_suffix();
+    test_hash();
+    test_split();
+}
+
+
+int main()
+{
+    tests();
+    printf("----- STRVIEW TESTS PASS ------\n");
+    return 0;
+}
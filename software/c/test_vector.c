@@ -0,0 +1,146 @@
+/* Vector tests. */
+#include <assert.h>
+#include <string.h>
+
+#include "vector.h"
+
+
+typedef struct {
+    size_t length;
+    char *s;
+} Pair;
+
+
+void test_newvec()
+{
+    Vector *v = newvec(sizeof(int));
+
+    assert(v->length == 0);
+    assert(v->_total_size == 16);
+    assert(v->elem_size == sizeof(int));
+    assert(vec_at(v, 0) == NULL);
+
+    freevec(v);
+}
+
+
+void test_emplace_back()
+{
+    Vector *v = newvec(sizeof(int));
+
+    for (int i = 0; i < 1000; i++) {
+        int *slot = emplace_back(v);
+        assert(slot != NULL);
+        // new slots come zeroed
+        assert(*slot == 0);
+        *slot = i;
+    }
+
+    assert(v->length == 1000);
+    assert(v->_total_size == 1024);
+
+    for (size_t i = 0; i < v->length; i++) {
+        assert(VEC_ITEMS(v, int)[i] == (int)i);
+        assert(*(int *)vec_at(v, i) == (int)i);
+    }
+
+    assert(vec_at(v, 1000) == NULL);
+
+    freevec(v);
+}
+
+
+void test_emplace_back__struct()
+{
+    char *test_strs[] = {"This", "is", "a", "test", "array"};
+
+    Vector *v = newvec(sizeof(Pair));
+
+    for (int i = 0; i < 5; i++) {
+        Pair *p = emplace_back(v);
+        p->s = test_strs[i];
+        p->length = strlen(test_strs[i]);
+    }
+
+    assert(v->length == 5);
+
+    // elements are stored inline, one after the other
+    Pair *items = VEC_ITEMS(v, Pair);
+    for (int i = 0; i < 5; i++) {
+        assert(&items[i] == vec_at(v, (size_t)i));
+        assert(items[i].s == test_strs[i]);
+        assert(items[i].length == strlen(test_strs[i]));
+    }
+
+    freevec(v);
+}
+
+
+void test_reserve()
+{
+    Vector *v = newvec(sizeof(int));
+
+    // never shrinks
+    assert(reserve(v, 4));
+    assert(v->_total_size == 16);
+
+    assert(reserve(v, 100));
+    assert(v->_total_size == 128);
+    assert(v->length == 0);
+
+    // no further growth while within the reserved size
+    char *items = v->items;
+    for (int i = 0; i < 128; i++)
+        *(int *)emplace_back(v) = i;
+
+    assert(v->items == items);
+    assert(v->_total_size == 128);
+
+    freevec(v);
+}
+
+
+void test_append()
+{
+    int nums[100];
+    for (int i = 0; i < 100; i++)
+        nums[i] = i;
+
+    Vector *v = newvec(sizeof(int));
+
+    assert(append(v, nums, 10));
+    assert(v->length == 10);
+    assert(v->_total_size == 16);
+
+    assert(append(v, nums, 100));
+    assert(v->length == 110);
+    assert(v->_total_size == 128);
+
+    for (size_t i = 0; i < v->length; i++)
+        assert(VEC_ITEMS(v, int)[i] == (int)(i < 10 ? i : i - 10));
+
+    // appending nothing is fine
+    assert(append(v, nums, 0));
+    assert(v->length == 110);
+
+    freevec(v);
+}
+
+
+void tests()
+{
+    test_newvec();
+    test_emplace_back();
+    test_emplace_back__struct();
+    test_reserve();
+    test_append();
+}
+
+
+int main()
+{
+    tests();
+
+    printf("----- VECTOR TESTS PASS ------\n");
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <assert.h>
 #include <stdio.h>
 
+#include "alloc.h"
 #include "mystring.h"
 
 
@@ -19,6 +20,13 @@ int issame(const char w1[], const char w2[])
 }
 
 
+/* compare a String's contents with a C string */
+int samestr(const String w, const char expected[])
+{
+    return issame(cstr(&w), expected);
+}
+
+
 void test_issame()
 {
     assert(issame("hello", "hello"));
@@ -47,15 +55,15 @@ void test_newstr_length()
 
 void test_newstr_actual_string()
 {
-    assert(issame(newstr("hello").s, "hello"));
-    assert(issame(newstr("This is a much longer word").s, "This is a much longer word"));
-    assert(!issame(newstr("hello ").s, "hello"));
-    assert(!issame(newstr("hello").s, "bello"));
-    assert(!issame(newstr("hhello").s, "hello"));
-    assert(!issame(newstr(" hello").s, "hello"));
+    assert(samestr(newstr("hello"), "hello"));
+    assert(samestr(newstr("This is a much longer word"), "This is a much longer word"));
+    assert(!samestr(newstr("hello "), "hello"));
+    assert(!samestr(newstr("hello"), "bello"));
+    assert(!samestr(newstr("hhello"), "hello"));
+    assert(!samestr(newstr(" hello"), "hello"));
 
     // empty string
-    assert(issame(newstr("").s, ""));    
+    assert(samestr(newstr(""), ""));    
 }
 
 
@@ -72,15 +80,15 @@ void test_concat__basic()
 
     w1 = newstr("this is ");
     w2 = newstr("a concatenated string");
-    assert(issame(concat(w1, w2).s, "this is a concatenated string"));
+    assert(samestr(concat(w1, w2), "this is a concatenated string"));
 
     w1 = newstr("");
     w2 = newstr("a concatenated string");
-    assert(issame(concat(w1, w2).s, "a concatenated string"));
+    assert(samestr(concat(w1, w2), "a concatenated string"));
 
     w1 = newstr("this is ");
     w2 = newstr("a concatenated string");
-    assert(!issame(concat(w1, w2).s, "this is a concatenated"));
+    assert(!samestr(concat(w1, w2), "this is a concatenated"));
 }
 
 
@@ -92,7 +100,7 @@ void test_concatRaw__basic()
     w1 = concatRaw(w1, "!!");
 
     assert(w1.length == (len + 2));
-    assert(issame(w1.s, "hello world!!"));
+    assert(samestr(w1, "hello world!!"));
 }
 
 
@@ -106,7 +114,7 @@ void test_concatRaw()
         w1 = concatRaw(w1, t[i]);
 
     assert(w1.length == 3);
-    assert(issame(w1.s, "abc"));
+    assert(samestr(w1, "abc"));
 }
 
 
@@ -120,7 +128,7 @@ void test_concatChar__basic()
         w1 = concatChar(w1, t[i]);
 
     assert(w1.length == 3);
-    assert(issame(w1.s, "abc"));
+    assert(samestr(w1, "abc"));
 }
 
 
@@ -134,7 +142,7 @@ void test_concatChar()
         w1 = concatChar(w1, t[i]);
 
     assert(w1.length == 11);
-    assert(issame(w1.s, "hello world"));
+    assert(samestr(w1, "hello world"));
 }
 
 
@@ -160,6 +168,59 @@ void test_concat()
 }
 
 
+void test_inline()
+{
+    // up to STR_INLINE_MAX characters live inside the String itself
+    String short_str = newstr("AMD");
+    assert(cstr(&short_str) == short_str._data.local);
+
+    String edge = newstr("1234567890123456789012");
+    assert(edge.length == STR_INLINE_MAX);
+    assert(cstr(&edge) == edge._data.local);
+    assert(samestr(edge, "1234567890123456789012"));
+
+    // one more and it goes on the heap
+    edge = concatChar(edge, "3");
+    assert(edge.length == STR_INLINE_MAX + 1);
+    assert(cstr(&edge) == edge._data.heap);
+    assert(samestr(edge, "12345678901234567890123"));
+    freestr(edge);
+
+    // copies carry inline characters with them
+    String copy = short_str;
+    short_str = concatChar(short_str, "!");
+    assert(samestr(copy, "AMD"));
+    assert(samestr(short_str, "AMD!"));
+
+    // concat across the boundary, both ways
+    String w = concat(newstr("0123456789"), newstr("0123456789abc"));
+    assert(w.length == 23);
+    assert(samestr(w, "01234567890123456789abc"));
+    freestr(w);
+
+    w = concat(newstr(""), newstr("D"));
+    assert(samestr(w, "D"));
+    assert(charat(w, 0) == 'D');
+}
+
+
+void test_dupstr()
+{
+    String w1 = newstr("M");
+    char *d1 = dupstr(w1);
+    assert(issame(d1, "M"));
+    assert(d1 != cstr(&w1));
+    mem_free(d1);
+
+    String w2 = newstr("This is a much longer word");
+    char *d2 = dupstr(w2);
+    assert(issame(d2, "This is a much longer word"));
+    assert(d2 != cstr(&w2));
+    mem_free(d2);
+    freestr(w2);
+}
+
+
 void test_startswith()
 {
     String w1 = newstr("// this is a comment");
@@ -202,6 +263,8 @@ void tests()
     test_concat();
     test_startswith();
     test_charat();
+    test_inline();
+    test_dupstr();
 }
 
 
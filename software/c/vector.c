@@ -0,0 +1,119 @@
+/* Dynamic array with inline, fixed size elements. */
+
+#include <string.h>
+
+#include "alloc.h"
+#include "vector.h"
+
+
+#define VECTOR_INIT_SIZE 16
+#define OOM "-------- OUT OF MEMORY ---------\n"
+
+
+/* Logging memory allocation errors */
+static void myprint(char *func_name, char *ptr_name, char *message)
+{
+    printf("(%s)-(%s): %s", func_name, ptr_name, message);
+}
+
+
+Vector * newvec(size_t elem_size)
+{
+    Vector *vec = mem_alloc(sizeof(*vec));
+    if (!vec)
+        goto error;
+
+    vec->length = 0;
+    vec->_total_size = VECTOR_INIT_SIZE;
+    vec->elem_size = elem_size;
+
+    vec->items = mem_alloc(elem_size * VECTOR_INIT_SIZE);
+    if (!vec->items)
+        goto items_error;
+
+    return vec;
+
+items_error:
+    mem_free(vec);
+
+error:
+    myprint("newvec", "vec", OOM);
+    return NULL;
+}
+
+
+bool reserve(Vector *vec, size_t n)
+{
+    if (n <= vec->_total_size)
+        return true;
+
+    // grow geometrically so a run of emplace_back's stays amortised O(1)
+    size_t new_size = vec->_total_size;
+    while (new_size < n) {
+        if (new_size * 2 < new_size)
+            goto overflow;
+        new_size *= 2;
+    }
+
+    if (new_size > (size_t)-1 / vec->elem_size)
+        goto overflow;
+
+    char *tmp = mem_realloc(vec->items, new_size * vec->elem_size);
+    if (!tmp) {
+        myprint("reserve", "tmp", OOM);
+        return false;
+    }
+
+    vec->items = tmp;
+    vec->_total_size = new_size;
+
+    return true;
+
+overflow:
+    myprint("reserve", "_total_size", "overflow issue\n");
+    return false;
+}
+
+
+void * emplace_back(Vector *vec)
+{
+    if (!reserve(vec, vec->length + 1))
+        return NULL;
+
+    void *slot = vec->items + vec->length * vec->elem_size;
+    memset(slot, 0, vec->elem_size);
+    vec->length++;
+
+    return slot;
+}
+
+
+bool append(Vector *vec, const void *src, size_t n)
+{
+    if (!reserve(vec, vec->length + n))
+        return false;
+
+    memcpy(vec->items + vec->length * vec->elem_size, src, n * vec->elem_size);
+    vec->length += n;
+
+    return true;
+}
+
+
+void * vec_at(Vector *vec, size_t idx)
+{
+    if (idx >= vec->length)
+        return NULL;
+
+    return vec->items + idx * vec->elem_size;
+}
+
+
+void freevec(Vector *vec)
+{
+    if (!vec)
+        return;
+
+    mem_free(vec->items);
+    mem_free(vec);
+}
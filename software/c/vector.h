@@ -0,0 +1,55 @@
+#ifndef VECTOR
+#define VECTOR
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/*
+A dynamic array that stores its elements inline: every element is
+elem_size bytes and they sit back to back in one block. Unlike Array there
+is no Item wrapper and no callback, pushing a String copies the struct
+itself, so there is no allocation per element and no pointer to chase on
+access.
+
+Typical use:
+
+    Vector *lines = newvec(sizeof(String));
+    *(String *)emplace_back(lines) = newstr("...");
+    String first = VEC_ITEMS(lines, String)[0];
+*/
+typedef struct {
+    size_t length;        // number of elements in use
+    size_t _total_size;   // number of elements there is room for
+    size_t elem_size;     // size in bytes of a single element
+    char *items;          // length * elem_size bytes of elements
+} Vector;
+
+
+// view the elements as a plain C array of type, e.g. VEC_ITEMS(v, String)[i]
+#define VEC_ITEMS(vec, type) ((type *)(vec)->items)
+
+
+Vector * newvec(size_t elem_size);
+
+/* make room for at least n elements, returns false if out of memory */
+bool reserve(Vector *, size_t n);
+
+/*
+add a zeroed element to the end and return a pointer to it so the caller
+can fill it in. The pointer is valid until the vector next grows.
+Returns NULL if out of memory.
+*/
+void * emplace_back(Vector *);
+
+/* copy n elements from src to the end, growing at most once */
+bool append(Vector *, const void *src, size_t n);
+
+/* pointer to the element at idx, or NULL if out of bounds */
+void * vec_at(Vector *, size_t idx);
+
+/* frees the vector only, elements that own memory must be freed first */
+void freevec(Vector *);
+
+#endif
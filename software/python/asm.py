@@ -95,12 +95,23 @@ symbol table for built in symbols:
 
 """
 import argparse
+import os
 import pathlib
 import sys
 
 import emit
 import utils
 
+# the C assembler, built with `make pymodule` in software/c. Without it, or
+# with HACK_ASM_PURE set, everything is done in Python below
+try:
+    import hackasm
+except ImportError:
+    hackasm = None
+
+if os.environ.get("HACK_ASM_PURE"):
+    hackasm = None
+
 # symbol tables
 dest: dict[str, str] = {
     "null": "000",
@@ -295,19 +306,21 @@ def _parse_instruction(line):
 def instruction(line):
     out = _parse_instruction(line)
 
-    x = ["1","1","1"]
-    # byte order is comp, dest, jump
-    if out["comp"] in comp_a_is_0:
-        x.append("0")
-        x.append(comp_a_is_0[out["comp"]])
-    else:
-        x.append("1")
-        x.append(comp_a_is_1[out["comp"]])
+    # 111a cccc ccdd djjj, as a 16 bit int
+    try:
+        if out["comp"] in comp_a_is_0:
+            word = 0b1110 << 12 | int(comp_a_is_0[out["comp"]], 2) << 6
+        else:
+            word = 0b1111 << 12 | int(comp_a_is_1[out["comp"]], 2) << 6
+
+        word |= int(dest[out["dest"]], 2) << 3
+        word |= int(jump[out["jump"]], 2)
 
-    x.append(dest[out["dest"]])
-    x.append(jump[out["jump"]])
+    # the same message as the C assembler
+    except KeyError:
+        raise ValueError(f"Invalid instruction: {line}") from None
 
-    return "".join(x)
+    return word
 
 
 def variable(line):
@@ -322,6 +335,10 @@ def variable(line):
     if utils.is_number(var):
         as_num = utils.atoi(var)
 
+        # anything wider would turn into a c instruction, or not fit at all
+        if not 0 <= as_num <= 0x7FFF:
+            raise ValueError("Invalid constant")
+
     else:
         # look up in symbol table
         if var not in symbols:
@@ -333,17 +350,23 @@ def variable(line):
 
         as_num = utils.atoi(symbols[var])
 
-    # turn the decimal number to binary
-    dec_bin = utils.dec_to_bin(as_num)
+    # 0vvv vvvv vvvv vvvv, rendered as text by emit
+    return as_num
 
-    return dec_bin
 
+def read(fp):
+    """Read a whole .asm file into a list of lines, both passes use it."""
+    with open(fp, "r") as fd:
+        return fd.readlines()
 
-def assemble(fp):
+
+def assemble(lines):
     # build symbole table in a first pass
-    build_symbol_table(fp)
+    build_symbol_table(lines)
+
+    words = []
 
-    for line in utils.readlines(fp):
+    for line in lines:
         fist_char_idx = utils.first(line)
 
         # -1 means its an empty str
@@ -357,18 +380,18 @@ def assemble(fp):
 
         # hadle variable
         if cleaned.startswith("@"):
-            emit.emit(variable(cleaned))
+            words.append(variable(cleaned))
         # handle instruction
         else:
-            emit.emit(instruction(cleaned))
-
+            words.append(instruction(cleaned))
 
-    # flush anything left in the buffer
+    # the whole program goes out in one write
+    emit.emit_batch(words)
     emit.flush()
 
 
-def build_symbol_table(fp):
-    for line in utils.readlines(fp):
+def build_symbol_table(lines):
+    for line in lines:
         if utils.first(line) == -1: continue
         # valid line of hack asm
         line = utils.clean(line)
@@ -409,6 +432,13 @@ def main():
         help="Print the symbol table to the console."
     )
 
+    parser.add_argument(
+        "--binary",
+        action="store_true",
+        help="Write each word as 2 bytes, high byte first, instead of a "
+             "line of 0s and 1s."
+    )
+
     return parser.parse_args()
 
 
@@ -419,15 +449,36 @@ if __name__ == "__main__":
         print("FILE DOES NOT EXIST!!")
         sys.exit(1)
 
-    if args.symbols_only:
-        build_symbol_table(args.file)
-        print(symbols)
+    try:
+        if hackasm is not None:
+            words = hackasm.assemble(args.file.read_bytes())
 
-    else:
-        # initialize .hack file
-        emit.init(args.out)
+            if args.symbols_only:
+                # labels go on top of the built in symbols, like
+                # build_symbol_table
+                print({**symbols, **hackasm.symbols()})
+
+            else:
+                emit.init(args.out, args.binary)
+                emit.emit_batch(words)
+                emit.flush()
+
+                print("Successfully assembled!!")
 
-        assemble(args.file)
-        print("Successfully assembled!!")
+        elif args.symbols_only:
+            build_symbol_table(read(args.file))
+            print(symbols)
+
+        else:
+            # initialize .hack file
+            emit.init(args.out, args.binary)
+
+            assemble(read(args.file))
+            print("Successfully assembled!!")
+
+    # bad input, whichever assembler found it
+    except ValueError as e:
+        print(e)
+        sys.exit(1)
 
     sys.exit(0)
@@ -1,33 +1,60 @@
-"""File buffer."""
+"""Output buffer.
+
+Encoded words, as 16 bit ints, are collected in memory and written to the
+output file with one open and one write when the assembly is done.
+
+Two output formats:
+    text:   one word per line as 16 "0"/"1" characters, the .hack format
+            written by the C assembler. Only rendered here, as the words
+            are buffered
+    binary: each word as 2 bytes, most significant byte first
+"""
+import array
+import io
+import sys
 
 OUT_FILE = None
-MAX_BUFFER_LENGTH = 2
-BUFFER = []
+BINARY = False
+BUFFER = io.BytesIO()
+
+# the 8 "0"/"1" characters of every byte, a word is two lookups
+BITS = [format(byte, "08b") for byte in range(256)]
 
 
-def init(fp):
-    global OUT_FILE
+def init(fp, binary=False):
+    global OUT_FILE, BINARY, BUFFER
 
     # set the file to write to
     OUT_FILE = fp
+    BINARY = binary
+    BUFFER = io.BytesIO()
 
 
 def emit(src):
+    emit_batch([src])
 
-    if len(BUFFER) >= MAX_BUFFER_LENGTH:
-        # write output to a file
-        flush()
 
-    BUFFER.append(src)
+def emit_batch(words):
+    """Buffer 16 bit words, a list or the array("H") hackasm.assemble() returns."""
 
+    if BINARY:
+        data = array.array("H", words)
+        if sys.byteorder == "little":
+            data.byteswap()
+
+        BUFFER.write(data.tobytes())
+    else:
+        BUFFER.write(
+            "".join(f"{BITS[word >> 8]}{BITS[word & 0xFF]}\n" for word in words)
+            .encode("ascii")
+        )
 
-def flush():
-    _write(len(BUFFER))
 
+def flush():
+    global BUFFER
 
-def _write(length=MAX_BUFFER_LENGTH):
+    # appended to, so several programs can go in one file
+    with open(OUT_FILE, "ab") as fp:
+        fp.write(BUFFER.getvalue())
 
-    with open(OUT_FILE, "a") as fp:
-        for i in range(length):
-            line = BUFFER.pop(0)
-            fp.write(f"{line}\n")
+    BUFFER = io.BytesIO()
@@ -1,6 +1,11 @@
 """Test assembler code."""
 
+import array
+import os
+import tempfile
+
 import asm
+import emit
 
 def test_get_variable():
     assert asm.get_variable("@123") == "123"
@@ -56,12 +61,120 @@ def test_parse_instruction():
         assert True
 
 
+def test_emit():
+    words = [0b0000000000000010, 0b1110110000010000]
+
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, "out.hack")
+
+        emit.init(out)
+        emit.emit_batch(words)
+        emit.emit(0xFFFF)
+        emit.flush()
+
+        with open(out, "rb") as fp:
+            assert fp.read() == (
+                b"0000000000000010\n1110110000010000\n1111111111111111\n"
+            )
+
+        out = os.path.join(tmp, "out.bin")
+
+        emit.init(out, binary=True)
+        emit.emit_batch(words)
+        emit.flush()
+        # flushing again appends nothing, the buffer went out already
+        emit.flush()
+
+        with open(out, "rb") as fp:
+            assert fp.read() == b"\x00\x02\xec\x10"
+
+        # the words from the C assembler go out the same way
+        emit.init(out, binary=True)
+        emit.emit_batch(array.array("H", words))
+        emit.flush()
+
+        with open(out, "rb") as fp:
+            assert fp.read() == b"\x00\x02\xec\x10" * 2
+
+
+def test_encode():
+    assert asm.instruction("D=A") == 0b1110110000010000
+    assert asm.instruction("0;JMP") == 0b1110101010000111
+    assert asm.instruction("AM=M+1") == 0b1111110111101000
+    assert asm.variable("@2") == 2
+    assert asm.variable("@32767") == 0x7FFF
+    assert asm.variable("@SCREEN") == 16384
+
+    for constant in ["@32768", "@-1"]:
+        try:
+            asm.variable(constant)
+            assert False
+
+        except ValueError as e:
+            assert str(e) == "Invalid constant"
+
+    # like the C assembler, and caught by the command line the same way
+    try:
+        asm.instruction("D=Q")
+        assert False
+
+    except ValueError as e:
+        assert str(e) == "Invalid instruction: D=Q"
+
+
+def test_c_assembler():
+    if asm.hackasm is None:
+        print("hackasm not built, skipping (make pymodule in software/c)")
+        return
+
+    source = b"@2\nD=A\n(LOOP)\n@sum\nM=D\n@LOOP\n0;JMP\n"
+    words = asm.hackasm.assemble(source)
+
+    assert words == array.array("H", [
+        0b0000000000000010,
+        0b1110110000010000,
+        0b0000000000010000,
+        0b1110001100001000,
+        0b0000000000000010,
+        0b1110101010000111,
+    ])
+    assert asm.hackasm.symbols() == {"LOOP": "2"}
+
+    try:
+        asm.hackasm.assemble(b"D=Q\n")
+        assert False
+
+    except ValueError as e:
+        assert str(e) == "Invalid instruction: D=Q"
+
+    # too long for any integer type, rejected like the pure Python path does
+    for constant in [b"@18446744073709551621", b"@32768"]:
+        try:
+            asm.hackasm.assemble(constant + b"\n")
+            assert False
+
+        except ValueError as e:
+            assert str(e) == "Invalid constant: " + constant.decode()
+
+        try:
+            asm.variable(constant.decode())
+            assert False
+
+        except ValueError as e:
+            assert str(e) == "Invalid constant"
+
+    # a failed assemble leaves the last symbols alone
+    assert asm.hackasm.symbols() == {"LOOP": "2"}
+
 
 def main():
     """Run tests."""
     test_get_variable()
     test_get_symbol_variable()
     test_parse_instruction()
+    test_emit()
+    test_encode()
+    test_c_assembler()
 
 
 if __name__ == "__main__":